@@ -0,0 +1 @@
+../src/util/myConcurrentHashSet.h
\ No newline at end of file
@@ -0,0 +1 @@
+../src/util/myHash.h
\ No newline at end of file
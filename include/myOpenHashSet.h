@@ -0,0 +1 @@
+../src/util/myOpenHashSet.h
\ No newline at end of file
@@ -0,0 +1 @@
+../src/util/myRadixHeap.h
\ No newline at end of file
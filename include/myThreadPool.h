@@ -0,0 +1 @@
+../src/util/myThreadPool.h
\ No newline at end of file
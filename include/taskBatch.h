@@ -0,0 +1 @@
+../src/task/taskBatch.h
\ No newline at end of file
@@ -0,0 +1 @@
+../src/task/taskConfig.h
\ No newline at end of file
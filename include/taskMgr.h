@@ -0,0 +1 @@
+../src/task/taskMgr.h
\ No newline at end of file
@@ -0,0 +1 @@
+../src/task/taskName.h
\ No newline at end of file
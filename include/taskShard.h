@@ -0,0 +1 @@
+../src/task/taskShard.h
\ No newline at end of file
@@ -0,0 +1,11 @@
+bench.o: bench.cpp ../../include/util.h ../../include/rnGen.h \
+  ../../include/myUsage.h ../../include/myHash.h ../../include/myHashSet.h \
+  ../../include/util.h ../../include/myHash.h ../../include/myStats.h \
+  ../../include/myArena.h ../../include/myOpenHashSet.h \
+  ../../include/myConcurrentHashSet.h ../../include/myMinHeap.h \
+  ../../include/myOpenHashSet.h ../../include/myMinHeap.h \
+  ../../include/myRadixHeap.h ../../include/taskMgr.h \
+  ../../include/myHashSet.h ../../include/myRadixHeap.h \
+  ../../include/taskConfig.h ../../include/taskName.h \
+  ../../include/taskShard.h ../../include/taskMgr.h \
+  ../../include/myConcurrentHashSet.h
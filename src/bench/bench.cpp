@@ -0,0 +1,624 @@
+/****************************************************************************
+  FileName     [ bench.cpp ]
+  PackageName  [ bench ]
+  Synopsis     [ Micro benchmarks of the hash and heap ADTs ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "util.h"
+#include "myHash.h"
+#include "myHashSet.h"
+#include "myOpenHashSet.h"
+#include "myConcurrentHashSet.h"
+#include "myMinHeap.h"
+#include "myRadixHeap.h"
+#include "taskMgr.h"
+#include "taskShard.h"
+
+using namespace std;
+
+//----------------------------------------------------------------------
+//    taskBench [-MAx (size_t maxSize)] [-MIn (size_t minSize)]
+//              [-HAsh | -HEap | -COncurrent | -SHard]
+//              [-THreads (size_t maxThreads)]
+//----------------------------------------------------------------------
+// Every structure is run at the sizes minSize, 10*minSize, ... up to
+// maxSize (default 1K ... 10M), with uniform and skewed keys.
+// ShardedTaskMgr is run with 1 (i.e. one global lock) and 64 shards, on
+// 1, 2, 4, ... up to maxThreads threads (default: the number of cores).
+// ConcurrentHashSet, and HashSet behind one mutex, are run with 1, 2, 4,
+// ... up to maxThreads readers and one writer; the readers also check
+// every datum they find, and the run fails on any wrong one.
+// TaskMgr is run with TASKAssign, one by one and with -Repeat, and the
+// run fails if the two differ.
+// Each (structure, size, keys) case runs in its own child process, so
+// that its peak RSS is its own.
+//
+// Output is CSV, one line per operation:
+//    struct,op,dist,n,ops,ns_per_op,mops,peak_rss_kb
+//
+// Keys:
+//    uniform ==> random 64-bit keys; every key equally likely to be
+//                looked up (hash) / random 32-bit keys (heap)
+//    skewed  ==> lookups follow a power law (index = n * u^4, so 1/16
+//                of the accesses hit the first 1/2^16 of the keys) /
+//                heap keys n * u^4, i.e. crowded at the small end
+//
+
+//----------------------------------------------------------------------
+//    Helpers
+//----------------------------------------------------------------------
+// splitmix64: fast and good enough for generating the keys
+class BenchRand
+{
+public:
+   BenchRand(uint64_t s) : _s(s) {}
+   uint64_t operator () () {
+      uint64_t z = (_s += 0x9e3779b97f4a7c15ull);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      return z ^ (z >> 31);
+   }
+   // in [0, 1)
+   double unit() { return ((*this)() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+   uint64_t _s;
+};
+
+enum BenchDist { BENCH_UNIFORM, BENCH_SKEWED };
+static const char* distName[] = { "uniform", "skewed" };
+
+// index in [0, n)
+static size_t
+pick(BenchRand& r, size_t n, BenchDist d)
+{
+   if (d == BENCH_UNIFORM) return r() % n;
+   double u = r.unit();
+   return size_t(n * u * u * u * u);
+}
+
+static double
+now()
+{
+   timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static long
+peakRss()
+{
+   struct rusage usage;
+   return (getrusage(RUSAGE_SELF, &usage) == 0)? usage.ru_maxrss: 0;
+}
+
+// defeats dead code elimination of the lookups
+static volatile size_t sink;
+
+static string
+benchName(BenchRand& r)
+{
+   char s[8];
+   for (size_t i = 0; i < 8; ++i) s[i] = 'a' + r() % 26;
+   return string(s, 8);
+}
+
+class BenchCase
+{
+public:
+   BenchCase(const char* s, BenchDist d, size_t n)
+      : _struct(s), _dist(d), _n(n) {}
+
+   void start() { _start = now(); }
+   void stop(const char* op, size_t ops) {
+      double t = now() - _start;
+      cout << _struct << ',' << op << ',' << distName[_dist] << ','
+           << _n << ',' << ops << ',' << (t * 1e9 / ops) << ','
+           << (ops / t * 1e-6) << ',' << peakRss() << endl;
+   }
+   BenchDist dist() const { return _dist; }
+   size_t size() const { return _n; }
+
+private:
+   const char*   _struct;
+   BenchDist     _dist;
+   size_t        _n;
+   double        _start;
+};
+
+//----------------------------------------------------------------------
+//    Hash benchmarks
+//----------------------------------------------------------------------
+struct BenchKey
+{
+   BenchKey(uint64_t k = 0, uint64_t v = 0) : _key(k), _value(v) {}
+   bool operator == (const BenchKey& k) const { return _key == k._key; }
+   size_t operator () () const {
+      return hash_detail::mix(_key ^ hash_detail::S0, hash_detail::S1); }
+
+   uint64_t   _key;
+   uint64_t   _value;
+};
+
+template <class Hash>
+static void
+benchHash(BenchCase& c)
+{
+   size_t n = c.size();
+   BenchRand r(n);
+   vector<uint64_t> keys(n);
+   for (size_t i = 0; i < n; ++i) keys[i] = r();
+
+   Hash h(getHashSize(n));
+   size_t found = 0;
+
+   c.start();
+   for (size_t i = 0; i < n; ++i)
+      found += h.insert(BenchKey(keys[i], i));
+   c.stop("insert", n);
+
+   c.start();
+   for (size_t i = 0; i < n; ++i) {
+      BenchKey k(keys[pick(r, n, c.dist())]);
+      found += h.query(k);
+   }
+   c.stop("query", n);
+
+   c.start();
+   for (size_t i = 0; i < n; ++i)
+      found += h.update(BenchKey(keys[pick(r, n, c.dist())], i));
+   c.stop("update", n);
+
+   c.start();
+   for (size_t i = 0; i < n; ++i)
+      found += h.remove(BenchKey(keys[pick(r, n, c.dist())]));
+   c.stop("remove", n);
+
+   sink = found;
+}
+
+//----------------------------------------------------------------------
+//    Heap benchmarks
+//----------------------------------------------------------------------
+static void
+heapKeys(BenchCase& c, vector<uint64_t>& keys)
+{
+   size_t n = c.size();
+   BenchRand r(n + 1);
+   keys.resize(n);
+   for (size_t i = 0; i < n; ++i)
+      keys[i] = (c.dist() == BENCH_UNIFORM)? (r() >> 32):
+                                             pick(r, n, c.dist());
+}
+
+// insert n; n times raise the min by 1..1000 (as TASKAssign does);
+// delData n/10 random slots; delMin the rest
+template <class Heap>
+static void
+benchMinHeap(BenchCase& c)
+{
+   vector<uint64_t> keys;
+   heapKeys(c, keys);
+   size_t n = keys.size(), del = n / 10;
+   BenchRand r(n + 2);
+   Heap h(n);
+
+   c.start();
+   for (size_t i = 0; i < n; ++i) h.insert(keys[i]);
+   c.stop("insert", n);
+
+   c.start();
+   for (size_t i = 0; i < n; ++i) {
+      h[0] += 1 + r() % 1000;
+      h.updateKey(0);
+   }
+   c.stop("incMin", n);
+
+   if (del != 0) {
+      c.start();
+      for (size_t i = 0; i < del; ++i) h.delData(r() % h.size());
+      c.stop("delData", del);
+   }
+
+   c.start();
+   while (h.size() != 0) h.delMin();
+   c.stop("delMin", n - del);
+}
+
+// the key of handle h is keys[h]
+struct BenchKeyOf
+{
+   typedef uint64_t Key;
+   BenchKeyOf(const vector<uint64_t>* k = 0) : _keys(k) {}
+   uint64_t operator () (uint32_t h) const { return (*_keys)[h]; }
+   bool operator () (uint32_t a, uint32_t b) const {
+      return (*_keys)[a] < (*_keys)[b]; }
+
+   const vector<uint64_t>*   _keys;
+};
+
+// same as benchMinHeap() on the handle based queues
+template <class Queue>
+static void
+benchQueue(BenchCase& c)
+{
+   vector<uint64_t> keys;
+   heapKeys(c, keys);
+   size_t n = keys.size(), del = n / 10;
+   BenchRand r(n + 2);
+   Queue q(BenchKeyOf(&keys), n);
+
+   c.start();
+   for (size_t i = 0; i < n; ++i) q.insert(i);
+   c.stop("insert", n);
+
+   c.start();
+   for (size_t i = 0; i < n; ++i) {
+      uint32_t h = q.min();
+      keys[h] += 1 + r() % 1000;
+      q.updateKey(q.slot(h));
+   }
+   c.stop("incMin", n);
+
+   if (del != 0) {
+      c.start();
+      for (size_t i = 0; i < del; ++i) q.delData(r() % q.size());
+      c.stop("delData", del);
+   }
+
+   c.start();
+   while (q.size() != 0) q.delMin();
+   c.stop("delMin", n - del);
+}
+
+// TASKAssign -Repeat: n assigns of load 7 to a TaskMgr of n nodes, one
+// by one with assign() and at once with assignBatch(); the run fails
+// unless both leave every node with the same load.
+static void
+benchAssign(BenchCase& c)
+{
+   vector<uint64_t> keys;
+   heapKeys(c, keys);
+   size_t n = keys.size();
+   BenchRand r(n + 5);
+   TaskMgr one(n), batch(n);
+   one.setSilent(true); batch.setSilent(true);
+   vector<string> names;
+   for (size_t i = 0; i < n; ) {
+      string s = benchName(r);
+      if (!one.add(s, keys[i])) continue;
+      batch.add(s, keys[i++]);
+      names.push_back(s);
+   }
+
+   c.start();
+   for (size_t i = 0; i < n; ++i) one.assign(7);
+   c.stop("assign", n);
+
+   c.start();
+   batch.assignBatch(7, n);
+   c.stop("assignBatch", n);
+
+   for (size_t i = 0; i < n; ++i) {
+      TaskNode a(names[i], 0), b(names[i], 0);
+      one.query(a); batch.query(b);
+      if (a.getLoad() != b.getLoad()) {
+         cerr << "Error: assignBatch gives " << b << " instead of " << a
+              << endl;
+         exit(1);
+      }
+   }
+}
+
+//----------------------------------------------------------------------
+//    Concurrent hash benchmark
+//----------------------------------------------------------------------
+// HashSet with one lock for everything: the baseline
+class LockedHashSet
+{
+public:
+   LockedHashSet(size_t b) : _hash(b) {}
+   bool query(BenchKey& k) const {
+      lock_guard<mutex> guard(_lock); return _hash.query(k); }
+   bool update(const BenchKey& k) {
+      lock_guard<mutex> guard(_lock); return _hash.update(k); }
+   bool insert(const BenchKey& k) {
+      lock_guard<mutex> guard(_lock); return _hash.insert(k); }
+   bool remove(const BenchKey& k) {
+      lock_guard<mutex> guard(_lock); return _hash.remove(k); }
+
+private:
+   HashSet<BenchKey>   _hash;
+   mutable mutex       _lock;
+};
+
+// The value of a key holds its low 32 bits, and a version below them;
+// so a torn or misplaced datum does not pass valid().
+static uint64_t
+tagged(uint64_t key, uint32_t version)
+{
+   return (key << 32) | version;
+}
+
+static bool
+valid(const BenchKey& k)
+{
+   return (k._value >> 32) == (k._key & 0xffffffffull);
+}
+
+// The keys of even indices are always in the hash (the writer only
+// updates them); those of odd indices come and go.
+template <class Hash>
+static void
+concReader(const Hash* h, const vector<uint64_t>* keys, uint64_t seed,
+           BenchDist d, size_t* found, atomic<size_t>* errors)
+{
+   BenchRand r(seed);
+   size_t n = keys->size(), f = 0, e = 0;
+   for (size_t i = 0; i < n; ++i) {
+      size_t j = pick(r, n, d);
+      BenchKey k((*keys)[j]);
+      if (h->query(k)) {
+         ++f;
+         if (!valid(k) || k._key != (*keys)[j]) ++e;
+      }
+      else if (j % 2 == 0) ++e;
+   }
+   *found = f;
+   *errors += e;
+}
+
+template <class Hash>
+static void
+concWriter(Hash* h, const vector<uint64_t>* keys, uint64_t seed,
+           const atomic<bool>* done, size_t* writes)
+{
+   BenchRand r(seed);
+   size_t n = keys->size(), w = 0;
+   for (uint32_t v = 1; !done->load(memory_order_relaxed); ++v, ++w) {
+      size_t j = r() % n;
+      BenchKey k((*keys)[j], tagged((*keys)[j], v));
+      if (j % 2 == 0) h->update(k);
+      else if (!h->remove(k)) h->insert(k);
+   }
+   *writes = w;
+}
+
+// n keys; every reader queries n times while the writer keeps changing
+// the hash. Exit with 1 on any wrong lookup.
+template <class Hash>
+static void
+benchConcurrent(BenchCase& c, size_t readers)
+{
+   size_t n = c.size();
+   BenchRand r(n + 5);
+   vector<uint64_t> keys(n);
+   for (size_t i = 0; i < n; ++i) keys[i] = r();
+   Hash h(getHashSize(n));
+   for (size_t i = 0; i < n; i += 2)
+      h.insert(BenchKey(keys[i], tagged(keys[i], 0)));
+
+   vector<size_t> found(readers);
+   atomic<size_t> errors(0);
+   atomic<bool> done(false);
+   size_t writes = 0;
+   vector<thread> workers;
+
+   c.start();
+   thread writer(concWriter<Hash>, &h, &keys, n + 6, &done, &writes);
+   for (size_t t = 0; t < readers; ++t)
+      workers.push_back(thread(concReader<Hash>, &h, &keys, n + 7 + t,
+                               c.dist(), &found[t], &errors));
+   for (size_t t = 0; t < readers; ++t) workers[t].join();
+   c.stop("query", n * readers);
+   done = true;
+   writer.join();
+   c.stop("write", writes);
+
+   for (size_t t = 0; t < readers; ++t) sink += found[t];
+   if (errors != 0) {
+      cerr << "Error: " << errors << " wrong lookups!!" << endl;
+      exit(1);
+   }
+}
+
+//----------------------------------------------------------------------
+//    Sharded task manager benchmark
+//----------------------------------------------------------------------
+// ops random operations of one thread: 20% add, 20% remove, 50% query,
+// 10% assign. Removes and queries pick from "pool", the names this
+// thread has added; queries follow the distribution of the case.
+static void
+shardWorker(ShardedTaskMgr* m, vector<string>* pool, size_t ops,
+            uint64_t seed, BenchDist d, size_t* found)
+{
+   BenchRand r(seed);
+   size_t f = 0;
+   for (size_t i = 0; i < ops; ++i) {
+      unsigned op = r() % 10;
+      if (op < 2 || pool->empty()) {
+         string s = benchName(r);
+         if (m->add(s, 1 + r() % 20000)) pool->push_back(s);
+      }
+      else if (op < 4) {
+         size_t j = r() % pool->size();
+         f += m->remove((*pool)[j]);
+         (*pool)[j].swap(pool->back());
+         pool->pop_back();
+      }
+      else if (op < 9) {
+         TaskNode n((*pool)[pick(r, pool->size(), d)], 0);
+         f += m->query(n);
+      }
+      else f += m->assign(1 + r() % 1000);
+   }
+   *found = f;
+}
+
+// n tasks, then n operations split over the threads
+static void
+benchShards(BenchCase& c, size_t shards, size_t threads)
+{
+   size_t n = c.size();
+   ShardedTaskMgr m(shards, n);
+   vector<vector<string> > pools(threads);
+   BenchRand r(n + 3);
+   for (size_t i = 0; i < n; ) {
+      string s = benchName(r);
+      if (m.add(s, 1 + r() % 20000)) pools[i++ % threads].push_back(s);
+   }
+   vector<size_t> found(threads);
+   vector<thread> workers;
+
+   c.start();
+   for (size_t t = 0; t < threads; ++t)
+      workers.push_back(thread(shardWorker, &m, &pools[t], n / threads,
+                               n + 4 + t, c.dist(), &found[t]));
+   for (size_t t = 0; t < threads; ++t) workers[t].join();
+   c.stop("mixed", n / threads * threads);
+   m.reclaim();
+
+   for (size_t t = 0; t < threads; ++t) sink += found[t];
+}
+
+//----------------------------------------------------------------------
+//    main
+//----------------------------------------------------------------------
+typedef void (*BenchFunc)(BenchCase&);
+
+struct BenchEntry
+{
+   const char*   _name;
+   bool          _isHash;
+   BenchFunc     _func;
+};
+
+static const BenchEntry benches[] = {
+   { "HashSet",       true,  benchHash<HashSet<BenchKey> > },
+   { "OpenHashSet",   true,  benchHash<OpenHashSet<BenchKey> > },
+   { "MinHeap2",      false, benchMinHeap<MinHeap<uint64_t, 2> > },
+   { "MinHeap4",      false, benchMinHeap<MinHeap<uint64_t, 4> > },
+   { "IdxMinHeap4",   false, benchQueue<IdxMinHeap<BenchKeyOf, 4> > },
+   { "KeyMinHeap2",   false, benchQueue<KeyMinHeap<BenchKeyOf, 2> > },
+   { "KeyMinHeap4",   false, benchQueue<KeyMinHeap<BenchKeyOf, 4> > },
+   { "RadixHeap",     false, benchQueue<RadixHeap<BenchKeyOf> > },
+   { "TaskMgr",       false, benchAssign }
+};
+
+typedef void (*ConcFunc)(BenchCase&, size_t);
+
+struct ConcEntry
+{
+   const char*   _name;
+   ConcFunc      _func;
+};
+
+static const ConcEntry concBenches[] = {
+   { "LockedHashSet",       benchConcurrent<LockedHashSet> },
+   { "ConcurrentHashSet",   benchConcurrent<ConcurrentHashSet<BenchKey> > }
+};
+
+static void
+usage()
+{
+   cerr << "Usage: taskBench [-MAx (size_t maxSize)] [-MIn (size_t minSize)]"
+        << "\n                 [-HAsh | -HEap | -COncurrent | -SHard]"
+        << " [-THreads (size_t maxThreads)]" << endl;
+   exit(-1);
+}
+
+int
+main(int argc, char** argv)
+{
+   size_t minSize = 1000, maxSize = 10000000;
+   size_t maxThreads = thread::hardware_concurrency();
+   if (maxThreads == 0) maxThreads = 1;
+   bool doHash = true, doHeap = true, doConc = true, doShard = true;
+   for (int i = 1; i < argc; ++i) {
+      string opt = argv[i];
+      int n;
+      if (myStrNCmp("-MAx", opt, 3) == 0 || myStrNCmp("-MIn", opt, 3) == 0 ||
+          myStrNCmp("-THreads", opt, 3) == 0) {
+         if (++i >= argc || !myStr2Int(argv[i], n) || n <= 0) usage();
+         if (myStrNCmp("-MAx", opt, 3) == 0) maxSize = n;
+         else if (myStrNCmp("-MIn", opt, 3) == 0) minSize = n;
+         else maxThreads = n;
+      }
+      else if (myStrNCmp("-HAsh", opt, 3) == 0)
+         doHeap = doConc = doShard = false;
+      else if (myStrNCmp("-HEap", opt, 3) == 0)
+         doHash = doConc = doShard = false;
+      else if (myStrNCmp("-COncurrent", opt, 3) == 0)
+         doHash = doHeap = doShard = false;
+      else if (myStrNCmp("-SHard", opt, 3) == 0)
+         doHash = doHeap = doConc = false;
+      else usage();
+   }
+
+   cout << "struct,op,dist,n,ops,ns_per_op,mops,peak_rss_kb" << endl;
+   bool failed = false;
+   for (size_t b = 0; b < sizeof(benches) / sizeof(BenchEntry); ++b) {
+      if (benches[b]._isHash? !doHash: !doHeap) continue;
+      for (size_t n = minSize; n <= maxSize; n *= 10)
+         for (int d = BENCH_UNIFORM; d <= BENCH_SKEWED; ++d) {
+            pid_t pid = fork();
+            if (pid == 0) {
+               BenchCase c(benches[b]._name, BenchDist(d), n);
+               benches[b]._func(c);
+               exit(0);
+            }
+            int status;
+            waitpid(pid, &status, 0);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+               failed = true;
+         }
+   }
+   for (size_t b = 0; doConc && b < 2; ++b)
+      for (size_t t = 1; t <= maxThreads; t *= 2)
+         for (size_t n = minSize; n <= maxSize; n *= 10)
+            for (int d = BENCH_UNIFORM; d <= BENCH_SKEWED; ++d) {
+               pid_t pid = fork();
+               if (pid == 0) {
+                  string name = string(concBenches[b]._name) + "/"
+                                + to_string(t) + "r";
+                  BenchCase c(name.c_str(), BenchDist(d), n);
+                  concBenches[b]._func(c, t);
+                  exit(0);
+               }
+               int status;
+               waitpid(pid, &status, 0);
+               if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                  failed = true;
+            }
+   static const size_t shardCounts[] = { 1, 64 };
+   for (size_t s = 0; doShard && s < 2; ++s)
+      for (size_t t = 1; t <= maxThreads; t *= 2)
+         for (size_t n = minSize; n <= maxSize; n *= 10)
+            for (int d = BENCH_UNIFORM; d <= BENCH_SKEWED; ++d) {
+               pid_t pid = fork();
+               if (pid == 0) {
+                  string name = "ShardedTaskMgr/" + to_string(shardCounts[s])
+                                + "x" + to_string(t);
+                  BenchCase c(name.c_str(), BenchDist(d), n);
+                  benchShards(c, shardCounts[s], t);
+                  exit(0);
+               }
+               int status;
+               waitpid(pid, &status, 0);
+            }
+   return failed? 1: 0;
+}
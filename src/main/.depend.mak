@@ -1 +1,8 @@
-main.o: main.cpp ../../include/cmdParser.h ../../include/cmdCharDef.h
+main.o: main.cpp ../../include/util.h ../../include/rnGen.h \
+  ../../include/myUsage.h ../../include/cmdParser.h \
+  ../../include/cmdCharDef.h ../../include/taskBatch.h \
+  ../../include/taskMgr.h ../../include/myHashSet.h ../../include/util.h \
+  ../../include/myHash.h ../../include/myStats.h ../../include/myArena.h \
+  ../../include/myOpenHashSet.h ../../include/myMinHeap.h \
+  ../../include/myRadixHeap.h ../../include/taskConfig.h \
+  ../../include/taskName.h ../../include/myThreadPool.h
@@ -9,6 +9,7 @@
 #include <cstdlib>
 #include "util.h"
 #include "cmdParser.h"
+#include "taskBatch.h"
 
 using namespace std;
 
@@ -23,7 +24,8 @@ extern bool initTaskCmd();
 static void
 usage()
 {
-   cout << "Usage: taskMgr [ -File < doFile > ]" << endl;
+   cout << "Usage: taskMgr [ -File < doFile > ] [ -Timing ]"
+        << " [ -Parallel [ numThreads ] ]" << endl;
 }
 
 static void
@@ -39,32 +41,66 @@ main(int argc, char** argv)
    myUsage.reset();
 
    ifstream dof;
+   bool timing = false, parallel = false;
+   int numThreads = 0;
 
-   if (argc == 3) {  // -file <doFile>
-      if (myStrNCmp("-File", argv[1], 2) == 0) {
-         if (!cmdMgr->openDofile(argv[2])) {
-            cerr << "Error: cannot open file \"" << argv[2] << "\"!!\n";
+   for (int i = 1; i < argc; ++i) {
+      if (myStrNCmp("-File", argv[i], 2) == 0) {  // -file <doFile>
+         if (++i == argc) {
+            cerr << "Error: missing dofile name!!\n";
             myexit();
          }
+         if (!cmdMgr->openDofile(argv[i])) {
+            cerr << "Error: cannot open file \"" << argv[i] << "\"!!\n";
+            myexit();
+         }
+      }
+      // print the time of each command, and all of them at the end
+      else if (myStrNCmp("-Timing", argv[i], 2) == 0)
+         timing = true;
+      // batch the commands on task names, and run them on numThreads
+      // threads (default: one per core); see taskBatch.h
+      else if (myStrNCmp("-Parallel", argv[i], 2) == 0) {
+         parallel = true;
+         if (i + 1 < argc && myStr2Int(argv[i + 1], numThreads)) {
+            if (numThreads <= 0) {
+               cerr << "Error: illegal number of threads \""
+                    << argv[i + 1] << "\"!!\n";
+               myexit();
+            }
+            ++i;
+         }
       }
       else {
-         cerr << "Error: unknown argument \"" << argv[1] << "\"!!\n";
+         cerr << "Error: unknown argument \"" << argv[i] << "\"!!\n";
          myexit();
       }
    }
-   else if (argc != 1) {
-      cerr << "Error: illegal number of argument (" << argc << ")!!\n";
-      myexit();
-   }
 
    if (!initCommonCmd() || !initTaskCmd())
       return 1;
+   // without -Timing the timers read no clock and record nothing
+   myProfile.setOn(timing);
+   if (parallel)
+      taskBatch = new TaskBatch(numThreads);
 
    CmdExecStatus status = CMD_EXEC_DONE;
    while (status != CMD_EXEC_QUIT) {  // until "quit" or command error
+      MyTimer timer("(all commands)", myProfile);
       status = cmdMgr->execOneCmd();
+      if (timing) {
+         streamsize p = cout.precision();
+         cout << "Elapsed time     : " << setprecision(4)
+              << timer.elapsed() * 1e-6 << " ms" << endl;
+         cout.precision(p);
+         myUsage.reportRss(cout);
+      }
       cout << endl;  // a blank line between each command
    }
+   delete taskBatch;  // the rest of the batch, and its output
+   taskBatch = 0;
+   if (timing)
+      myProfile.report(cout);
 
    return 0;
 }
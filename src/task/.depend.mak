@@ -1,7 +1,45 @@
+taskBatch.o: taskBatch.cpp taskBatch.h taskMgr.h \
+  ../../include/myHashSet.h ../../include/util.h ../../include/rnGen.h \
+  ../../include/myUsage.h ../../include/myHash.h ../../include/myStats.h \
+  ../../include/myArena.h ../../include/myOpenHashSet.h \
+  ../../include/myMinHeap.h ../../include/myRadixHeap.h \
+  ../../include/myArena.h taskConfig.h taskName.h \
+  ../../include/myThreadPool.h taskOut.h ../../include/util.h
+taskBench.o: taskBench.cpp taskBench.h taskMgr.h \
+  ../../include/myHashSet.h ../../include/util.h ../../include/rnGen.h \
+  ../../include/myUsage.h ../../include/myHash.h ../../include/myStats.h \
+  ../../include/myArena.h ../../include/myOpenHashSet.h \
+  ../../include/myMinHeap.h ../../include/myRadixHeap.h \
+  ../../include/myArena.h taskConfig.h taskName.h ../../include/util.h
 taskCmd.o: taskCmd.cpp taskMgr.h ../../include/myHashSet.h \
-  ../../include/myMinHeap.h taskCmd.h ../../include/cmdParser.h \
-  ../../include/cmdCharDef.h ../../include/util.h ../../include/rnGen.h \
-  ../../include/myUsage.h
+  ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h \
+  ../../include/myHash.h ../../include/myStats.h ../../include/myArena.h \
+  ../../include/myOpenHashSet.h ../../include/myMinHeap.h \
+  ../../include/myRadixHeap.h ../../include/myArena.h taskConfig.h \
+ taskName.h taskCmd.h ../../include/cmdParser.h \
+  ../../include/cmdCharDef.h taskOut.h ../../include/util.h taskBench.h \
+ taskBatch.h ../../include/myThreadPool.h ../../include/myStats.h
 taskMgr.o: taskMgr.cpp taskMgr.h ../../include/myHashSet.h \
-  ../../include/myMinHeap.h ../../include/rnGen.h ../../include/util.h \
-  ../../include/myUsage.h
+  ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h \
+  ../../include/myHash.h ../../include/myStats.h ../../include/myArena.h \
+  ../../include/myOpenHashSet.h ../../include/myMinHeap.h \
+  ../../include/myRadixHeap.h ../../include/myArena.h taskConfig.h \
+ taskName.h taskOut.h ../../include/util.h ../../include/rnGen.h \
+  ../../include/myStats.h
+taskName.o: taskName.cpp taskName.h ../../include/myHash.h
+taskOut.o: taskOut.cpp taskOut.h ../../include/util.h \
+  ../../include/rnGen.h ../../include/myUsage.h
+taskShard.o: taskShard.cpp taskShard.h taskMgr.h \
+  ../../include/myHashSet.h ../../include/util.h ../../include/rnGen.h \
+  ../../include/myUsage.h ../../include/myHash.h ../../include/myStats.h \
+  ../../include/myArena.h ../../include/myOpenHashSet.h \
+  ../../include/myMinHeap.h ../../include/myRadixHeap.h \
+  ../../include/myArena.h taskConfig.h taskName.h \
+  ../../include/myConcurrentHashSet.h ../../include/myMinHeap.h \
+  ../../include/myOpenHashSet.h
+taskSnap.o: taskSnap.cpp taskMgr.h ../../include/myHashSet.h \
+  ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h \
+  ../../include/myHash.h ../../include/myStats.h ../../include/myArena.h \
+  ../../include/myOpenHashSet.h ../../include/myMinHeap.h \
+  ../../include/myRadixHeap.h ../../include/myArena.h taskConfig.h \
+ taskName.h ../../include/myHash.h
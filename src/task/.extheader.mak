@@ -1 +1,13 @@
-task.d: 
+task.d: ../../include/taskName.h ../../include/taskMgr.h ../../include/taskShard.h ../../include/taskBatch.h 
+../../include/taskName.h: taskName.h
+	@rm -f ../../include/taskName.h
+	@ln -fs ../src/task/taskName.h ../../include/taskName.h
+../../include/taskMgr.h: taskMgr.h
+	@rm -f ../../include/taskMgr.h
+	@ln -fs ../src/task/taskMgr.h ../../include/taskMgr.h
+../../include/taskShard.h: taskShard.h
+	@rm -f ../../include/taskShard.h
+	@ln -fs ../src/task/taskShard.h ../../include/taskShard.h
+../../include/taskBatch.h: taskBatch.h
+	@rm -f ../../include/taskBatch.h
+	@ln -fs ../src/task/taskBatch.h ../../include/taskBatch.h
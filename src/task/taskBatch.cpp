@@ -0,0 +1,297 @@
+/****************************************************************************
+  FileName     [ taskBatch.cpp ]
+  PackageName  [ task ]
+  Synopsis     [ Define the batched, parallel execution of task commands ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include <unordered_map>
+#include "taskBatch.h"
+#include "taskOut.h"
+
+using namespace std;
+
+TaskBatch* taskBatch = 0;
+
+extern TaskMgr* taskMgr;
+
+//----------------------------------------------------------------------
+//    TaskNameOp
+//----------------------------------------------------------------------
+void
+TaskNameOp::run()
+{
+  switch( _kind )
+  {
+    case NEW:
+      _ok = taskMgr->add( _node.getName().str(), _node.getLoad() );
+      break;
+    case REMOVE:
+      _ok = taskMgr->remove( _node.getName().str() );
+      break;
+    case QUERY:
+      _ok = taskMgr->query( _node );
+      break;
+  }
+  report();
+}
+
+void
+TaskNameOp::report() const
+{
+  const TaskName& name = _node.getName();
+  switch( _kind )
+  {
+    case NEW:
+      if( !_ok )
+        cerr << "Error: Task node (" << name << ") already exists.\n";
+      break;
+    case REMOVE:
+      if( !_ok )
+        cerr << "Error: Task node (" << name << ") does not exist.\n";
+      break;
+    case QUERY:
+      if( !_ok )
+        cerr << "Query fails!" << endl;
+      else if( taskOut.enabled() )
+        taskOut.os() << "Query succeeds: " << _node << endl;
+      break;
+  }
+}
+
+//----------------------------------------------------------------------
+//    TaskBatchOut
+//----------------------------------------------------------------------
+TaskBatchOut::TaskBatchOut()
+: _outBuf( this, false ), _errBuf( this, true ), _target( &_main )
+{
+  _cout = cout.rdbuf( &_outBuf );
+  _cerr = cerr.rdbuf( &_errBuf );
+}
+
+TaskBatchOut::~TaskBatchOut()
+{
+  write();
+  cout.rdbuf( _cout );
+  cerr.rdbuf( _cerr );
+}
+
+void
+TaskBatchOut::hold()
+{
+  _main.push_back( Piece( false, _ops.size() ) );
+  _ops.push_back( Pieces() );
+}
+
+void
+TaskBatchOut::append( bool err, const char* s, size_t n )
+{
+  if( direct() )
+  {
+    // no op is pending, so nothing can come before it
+    assert( _main.empty() );
+    put( err, s, n );
+    return;
+  }
+  Pieces& p = *_target;
+  if( p.empty() || p.back()._err != err || p.back()._op != NO_OP )
+    p.push_back( Piece( err, NO_OP ) );
+  p.back()._text.append( s, n );
+}
+
+// cout is flushed before anything goes to cerr, as endl would have done
+void
+TaskBatchOut::put( bool err, const char* s, size_t n )
+{
+  if( err )
+  {
+    _cout->pubsync();
+    _cerr->sputn( s, n );
+  }
+  else
+    _cout->sputn( s, n );
+}
+
+void
+TaskBatchOut::write()
+{
+  assert( _target == &_main );
+  for( size_t i = 0; i < _main.size(); ++i )
+  {
+    if( _main[i]._op == NO_OP )
+      put( _main[i] );
+    else
+    {
+      const Pieces& p = _ops[_main[i]._op];
+      for( size_t j = 0; j < p.size(); ++j )
+        put( p[j] );
+    }
+  }
+  _cout->pubsync();
+  _main.clear();
+  _ops.clear();
+}
+
+TaskBatchOut::Buf::int_type
+TaskBatchOut::Buf::overflow( int_type c )
+{
+  if( !traits_type::eq_int_type( c, traits_type::eof() ) )
+  {
+    char ch = traits_type::to_char_type( c );
+    _out->append( _err, &ch, 1 );
+  }
+  return traits_type::not_eof( c );
+}
+
+streamsize
+TaskBatchOut::Buf::xsputn( const char* s, streamsize n )
+{
+  _out->append( _err, s, n );
+  return n;
+}
+
+// flush (e.g. endl) reaches the real buffer only when it has it all
+int
+TaskBatchOut::Buf::sync()
+{
+  if( !_out->direct() )
+    return 0;
+  return ( _err? _out->_cerr: _out->_cout )->pubsync();
+}
+
+//----------------------------------------------------------------------
+//    TaskBatch
+//----------------------------------------------------------------------
+// the histograms of -DMY_STATS are not locked
+static size_t
+poolSize( size_t n )
+{
+#ifdef MY_STATS
+  return 1;
+#else
+  return n;
+#endif
+}
+
+TaskBatch::TaskBatch( size_t n )
+: _pool( poolSize( n ) ), _syncBuf( this ), _syncOs( &_syncBuf )
+{
+  _tie = cin.tie( &_syncOs );
+}
+
+TaskBatch::~TaskBatch()
+{
+  sync();
+  cin.tie( _tie );
+}
+
+void
+TaskBatch::defer( const TaskNameOp& op )
+{
+  _ops.push_back( op );
+  _out.hold();
+  if( _ops.size() == TASK_BATCH_SIZE )
+    sync();
+}
+
+void
+TaskBatch::sync()
+{
+  if( !_ops.empty() )
+  {
+    // all the ops on a name fall into the same group, in order
+    size_t n = _pool.size() * TASK_BATCH_GROUPS;
+    vector<vector<size_t> > groups( n );
+    for( size_t i = 0; i < _ops.size(); ++i )
+      groups[_ops[i]._node.getName().hash() % n].push_back( i );
+    vector<MyThreadPool::Job> jobs;
+    for( size_t g = 0; g < n; ++g )
+      if( !groups[g].empty() )
+        jobs.push_back( bind( &TaskBatch::resolve, this,
+                              cref( groups[g] ) ) );
+    _pool.run( jobs );
+
+    for( size_t i = 0; i < _ops.size(); ++i )
+    {
+      _out.select( i );
+      apply( _ops[i] );
+    }
+    _out.selectMain();
+    _ops.clear();
+  }
+  _out.write();
+}
+
+namespace
+{
+   struct NameHash
+   {
+      size_t operator () (const TaskName& n) const { return n.hash(); }
+   };
+   // a node as left by the ops so far
+   struct NameState
+   {
+      bool     _in;
+      size_t   _load;
+   };
+}
+
+void
+TaskBatch::resolve( const vector<size_t>& group )
+{
+  unordered_map<TaskName, NameState, NameHash> names;
+  for( size_t i = 0; i < group.size(); ++i )
+  {
+    TaskNameOp& op = _ops[group[i]];
+    const TaskName& name = op._node.getName();
+    auto it = names.find( name );
+    if( it == names.end() )
+    {
+      TaskNode n( name, 0 );
+      NameState s = { taskMgr->query( n ), n.getLoad() };
+      it = names.insert( make_pair( name, s ) ).first;
+    }
+    NameState& s = it->second;
+    switch( op._kind )
+    {
+      case TaskNameOp::NEW:
+        op._ok = !s._in;
+        if( op._ok )
+        {
+          s._in = true;
+          s._load = op._node.getLoad();
+        }
+        break;
+      case TaskNameOp::REMOVE:
+        op._ok = s._in;
+        s._in = false;
+        break;
+      case TaskNameOp::QUERY:
+        op._ok = s._in;
+        if( op._ok )
+          op._node = TaskNode( name, s._load );
+        break;
+    }
+  }
+}
+
+// the same as op.run(), with the result known: a NEW is not looked for
+void
+TaskBatch::apply( TaskNameOp& op )
+{
+  if( op._ok && op._kind != TaskNameOp::QUERY )
+  {
+    const string name = op._node.getName().str();
+    if( op._kind == TaskNameOp::NEW )
+      taskMgr->addNew( name, op._node.getLoad() );
+    else
+    {
+      bool done = taskMgr->remove( name );
+      assert( done );
+    }
+  }
+  op.report();
+  taskOut.flush();
+}
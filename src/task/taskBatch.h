@@ -0,0 +1,172 @@
+/****************************************************************************
+  FileName     [ taskBatch.h ]
+  PackageName  [ task ]
+  Synopsis     [ Define the batched, parallel execution of task commands ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef TASK_BATCH_H
+#define TASK_BATCH_H
+
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "taskMgr.h"
+#include "myThreadPool.h"
+
+using namespace std;
+
+class TaskBatch;
+
+extern TaskBatch* taskBatch;
+
+//----------------------------------------------------------------------
+//    TaskNameOp: a task command on one name
+//----------------------------------------------------------------------
+// TASKNew -Name, TASKRemove -Name and TASKQuery <name>: they only touch
+// the node of their name, so the ones on different names are
+// independent, and may be deferred (see TaskBatch).
+//
+struct TaskNameOp
+{
+   enum Kind { NEW, REMOVE, QUERY };
+
+   TaskNameOp(Kind k, const string& n, size_t l = 0)
+      : _kind(k), _node(n, l), _ok(false) {}
+
+   // do it on taskMgr and print the result, as the command does
+   void run();
+   // print the result, as the command does
+   void report() const;
+
+   Kind       _kind;
+   TaskNode   _node;   // the load of NEW, or the one found by QUERY
+   bool       _ok;     // the result
+};
+
+//----------------------------------------------------------------------
+//    TaskBatchOut: the output while batching
+//----------------------------------------------------------------------
+// cout and cerr are both diverted into one sequence of pieces, in which
+// every deferred op holds a place for its own output; everything is
+// written out in order once those are filled. While no op is deferred,
+// the output goes straight through, so little is ever held in memory.
+//
+class TaskBatchOut
+{
+public:
+   TaskBatchOut() ;
+   ~TaskBatchOut() ;
+
+   // a place for the output of the next op (numbered from 0)
+   void hold();
+   // send the output to the place of op i, or back to the end
+   void select(size_t i) { _target = &_ops[i]; }
+   void selectMain() { _target = &_main; }
+   // write out everything and start over
+   void write();
+
+private:
+   struct Piece
+   {
+      Piece(bool e, size_t op) : _err(e), _op(op) {}
+      bool     _err;     // to cerr
+      size_t   _op;      // place of this op if != NO_OP; else _text
+      string   _text;
+   };
+   typedef vector<Piece> Pieces;
+
+   class Buf : public streambuf
+   {
+   public:
+      Buf(TaskBatchOut* o, bool err) : _out(o), _err(err) {}
+
+   protected:
+      int_type overflow(int_type c);
+      streamsize xsputn(const char* s, streamsize n);
+      int sync();
+
+   private:
+      TaskBatchOut*   _out;
+      bool            _err;
+   };
+
+   Buf              _outBuf;
+   Buf              _errBuf;
+   streambuf*       _cout;      // the real ones
+   streambuf*       _cerr;
+   Pieces           _main;
+   vector<Pieces>   _ops;
+   Pieces*          _target;
+
+   static const size_t NO_OP = size_t(-1);
+
+   // nothing is held back for an op
+   bool direct() const { return _ops.empty() && _target == &_main; }
+   void append(bool err, const char* s, size_t n);
+   void put(bool err, const char* s, size_t n);
+   void put(const Piece& p) { put(p._err, p._text.data(), p._text.size()); }
+};
+
+//----------------------------------------------------------------------
+//    TaskBatch: the parallel executor
+//----------------------------------------------------------------------
+// While "taskBatch" is set, the name commands defer their TaskNameOp to
+// it instead of running it, and every other task command calls sync()
+// first; taskMgr is thus only changed by the commands in sync().
+//
+// sync() runs the deferred ops in two steps:
+//    1. resolve: the ops are split by name into groups, which run on a
+//       work-stealing thread pool. Each group works out, in order, the
+//       results of its ops from the state of taskMgr before the batch;
+//       taskMgr is only read here.
+//    2. apply: the successful NEW/REMOVE are done on taskMgr in their
+//       original order, so that the heap comes out exactly as if run
+//       one by one, and every op prints into its place. This step is
+//       on one thread: taskMgr is not thread safe, and ShardedTaskMgr
+//       would not keep that order. A NEW is not looked up again.
+// The results, and hence the output, are the same as sequential runs.
+// QUERY, the bulk of most workloads, is done entirely in step 1.
+//
+// The output is held (see TaskBatchOut) until sync(), which also runs
+// every TASK_BATCH_SIZE ops, before reading from stdin, and at the end.
+//
+class TaskBatch
+{
+#define TASK_BATCH_SIZE     (1 << 16)
+#define TASK_BATCH_GROUPS   8      // per thread
+
+public:
+   // n == 0 ==> one thread per core
+   TaskBatch(size_t n = 0) ;
+   ~TaskBatch() ;
+
+   void defer(const TaskNameOp& op) ;
+   void sync() ;
+
+private:
+   // flushed (e.g. by cin, to which it is tied) ==> sync()
+   class SyncBuf : public streambuf
+   {
+   public:
+      SyncBuf(TaskBatch* b) : _batch(b) {}
+   protected:
+      int sync() { _batch->sync(); return 0; }
+   private:
+      TaskBatch*   _batch;
+   };
+
+   MyThreadPool         _pool;
+   TaskBatchOut         _out;
+   vector<TaskNameOp>   _ops;
+   SyncBuf              _syncBuf;
+   ostream              _syncOs;
+   ostream*             _tie;       // of cin, before
+
+   void resolve(const vector<size_t>& group) ;
+   void apply(TaskNameOp& op) ;
+};
+
+#endif // TASK_BATCH_H
@@ -0,0 +1,180 @@
+/****************************************************************************
+  FileName     [ taskBench.cpp ]
+  PackageName  [ task ]
+  Synopsis     [ Define the synthetic workload of TASKBench ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iomanip>
+#include <algorithm>
+#include <cassert>
+#include <time.h>
+#include "taskBench.h"
+#include "util.h"
+
+using namespace std;
+
+static const char* opNames[TASK_BENCH_TOT] =
+   { "new", "remove", "query", "assign" };
+
+static uint64_t
+nowNs()
+{
+  timespec t;
+  clock_gettime( CLOCK_MONOTONIC, &t );
+  return uint64_t( t.tv_sec ) * 1000000000ull + t.tv_nsec;
+}
+
+bool
+TaskBench::setMix( const size_t mix[TASK_BENCH_TOT] )
+{
+  size_t sum = 0;
+  for( size_t i = 0; i < TASK_BENCH_TOT; ++i )
+    sum += mix[i];
+  if( sum == 0 )
+    return false;
+  for( size_t i = 0; i < TASK_BENCH_TOT; ++i )
+    _mix[i] = mix[i];
+  return true;
+}
+
+TaskBenchOp
+TaskBench::pickOp()
+{
+  size_t sum = 0;
+  for( size_t i = 0; i < TASK_BENCH_TOT; ++i )
+    sum += _mix[i];
+  assert( sum <= UINT32_MAX );
+  size_t r = _rn( uint32_t( sum ) );
+  size_t i = 0;
+  while( r >= _mix[i] )
+    r -= _mix[i++];
+  return TaskBenchOp( i );
+}
+
+size_t
+TaskBench::pickName()
+{
+  double u = _rn.unit(), p = u;
+  for( size_t s = 0; s < _skew; ++s )
+    p *= u;
+  size_t i = size_t( _names.size() * p );
+  return ( i < _names.size() )? i: _names.size()-1;
+}
+
+// Do one operation and time the TaskMgr call only, not the making of its
+// arguments. Return what the call returns.
+bool
+TaskBench::doOp( TaskBenchOp op )
+{
+  bool ok = false;
+  uint64_t start = 0, stop = 0;
+  switch( op )
+  {
+    case TASK_BENCH_NEW:
+    {
+      TaskNode n( _rn );
+      string name = n.getName().str();
+      start = nowNs();
+      ok = _mgr.add( name, n.getLoad() );
+      stop = nowNs();
+      if( ok )
+        _names.push_back( name );
+      break;
+    }
+    case TASK_BENCH_REMOVE:
+    {
+      // with no known name left, a random one (most likely a miss)
+      if( _names.empty() )
+      {
+        string name = TaskNode( _rn ).getName().str();
+        start = nowNs();
+        ok = _mgr.remove( name );
+        stop = nowNs();
+        break;
+      }
+      size_t i = pickName();
+      start = nowNs();
+      ok = _mgr.remove( _names[i] );
+      stop = nowNs();
+      _names[i].swap( _names.back() );
+      _names.pop_back();
+      break;
+    }
+    case TASK_BENCH_QUERY:
+    {
+      TaskNode n( _names.empty()? TaskNode( _rn ).getName().str():
+                                  _names[pickName()], 0 );
+      start = nowNs();
+      ok = _mgr.query( n );
+      stop = nowNs();
+      break;
+    }
+    default:
+    {
+      size_t l = 1 + _rn( TASK_BENCH_LOAD );
+      start = nowNs();
+      ok = _mgr.assign( l );
+      stop = nowNs();
+      break;
+    }
+  }
+  uint64_t ns = stop - start;
+  _stats[op]._ns.push_back( ns < UINT32_MAX? uint32_t( ns ): UINT32_MAX );
+  if( ok )
+    ++_stats[op]._succeeded;
+  return ok;
+}
+
+void
+TaskBench::run( size_t numOps )
+{
+  _names.clear();
+  _names.reserve( _mgr.size() + numOps );
+  for( size_t i = 0, n = _mgr.size(); i < n; ++i )
+    _names.push_back( _mgr[i].getName().str() );
+  for( size_t i = 0; i < TASK_BENCH_TOT; ++i )
+  {
+    _stats[i] = OpStat();
+    _stats[i]._ns.reserve( numOps * _mix[i] / ( _mix[0] + _mix[1]
+                           + _mix[2] + _mix[3] ) + 1 );
+  }
+
+  uint64_t start = nowNs();
+  for( size_t i = 0; i < numOps; ++i )
+    doOp( pickOp() );
+  _seconds = ( nowNs() - start ) * 1e-9;
+}
+
+void
+TaskBench::report( ostream& os ) const
+{
+  size_t total = 0;
+  for( size_t i = 0; i < TASK_BENCH_TOT; ++i )
+    total += _stats[i]._ns.size();
+  os << total << " operations in " << _seconds << " seconds ("
+     << size_t( _seconds > 0? total / _seconds: 0 ) << " ops/s)" << endl;
+
+  os << left << setw(8) << "op" << right << setw(10) << "count"
+     << setw(10) << "succeeded" << setw(10) << "mean(ns)"
+     << setw(10) << "p50(ns)" << setw(10) << "p99(ns)"
+     << setw(10) << "p999(ns)" << setw(12) << "max(ns)" << endl;
+  for( size_t i = 0; i < TASK_BENCH_TOT; ++i )
+  {
+    vector<uint32_t> ns( _stats[i]._ns );
+    size_t n = ns.size();
+    if( n == 0 )
+      continue;
+    sort( ns.begin(), ns.end() );
+    double sum = 0;
+    for( size_t j = 0; j < n; ++j )
+      sum += ns[j];
+    auto pct = [&]( double p ) {
+      return ns[std::min( n-1, size_t( p * n ) )]; };
+    os << left << setw(8) << opNames[i] << right << setw(10) << n
+       << setw(10) << _stats[i]._succeeded << setw(10) << size_t( sum / n )
+       << setw(10) << pct( 0.5 ) << setw(10) << pct( 0.99 )
+       << setw(10) << pct( 0.999 ) << setw(12) << ns[n-1] << endl;
+  }
+}
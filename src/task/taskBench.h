@@ -0,0 +1,88 @@
+/****************************************************************************
+  FileName     [ taskBench.h ]
+  PackageName  [ task ]
+  Synopsis     [ Define the synthetic workload of TASKBench ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef TASK_BENCH_H
+#define TASK_BENCH_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <climits>
+#include "taskMgr.h"
+#include "util.h"
+
+using namespace std;
+
+//----------------------------------------------------------------------
+//    TaskBench: a random mix of operations on a TaskMgr
+//----------------------------------------------------------------------
+// Each operation is one of
+//    new    ==> add(name, load) with a random TaskNode
+//    remove ==> remove(name) of a known name
+//    query  ==> query() of a known name
+//    assign ==> assign(load) with a random load in [1, TASK_BENCH_LOAD]
+// picked with the given weights. The known names are the tasks in the
+// manager when run() starts plus the ones added since; "skew" s picks
+// the i-th of n of them with i = n * u^(s+1), u uniform in [0, 1), so
+// s = 0 is uniform and a larger s keeps hitting the same few names.
+//
+// Every operation is timed on its own (CLOCK_MONOTONIC); report() gives
+// the throughput and the latency percentiles per operation type.
+// All the random numbers come from a FastRandomNumGen of its own,
+// seeded by setSeed() or else from rnGen; rnGen is not used otherwise.
+//
+enum TaskBenchOp
+{
+   TASK_BENCH_NEW,
+   TASK_BENCH_REMOVE,
+   TASK_BENCH_QUERY,
+   TASK_BENCH_ASSIGN,
+
+   TASK_BENCH_TOT
+};
+
+class TaskBench
+{
+#define TASK_BENCH_LOAD   1000
+
+public:
+   TaskBench(TaskMgr& m) : _mgr(m), _skew(0), _seconds(0),
+      _rn(rnGen(INT_MAX)) {
+      for (size_t i = 0; i < TASK_BENCH_TOT; ++i) _mix[i] = 1; }
+
+   // false if all the weights are 0; they add up to UINT32_MAX at most
+   bool setMix(const size_t mix[TASK_BENCH_TOT]);
+   void setSkew(size_t s) { _skew = s; }
+   void setSeed(size_t s) { _rn.setSeed(s); }
+
+   void run(size_t numOps);
+   void report(ostream& os) const;
+
+private:
+   struct OpStat
+   {
+      OpStat() : _succeeded(0) {}
+      vector<uint32_t>   _ns;          // latency of each call
+      size_t             _succeeded;   // calls that returned true
+   };
+
+   TaskMgr&         _mgr;
+   size_t           _mix[TASK_BENCH_TOT];
+   size_t           _skew;
+   vector<string>   _names;
+   OpStat           _stats[TASK_BENCH_TOT];
+   double           _seconds;      // wall time of the whole run()
+   FastRandomNumGen _rn;
+
+   TaskBenchOp pickOp();
+   size_t pickName();
+   bool doOp(TaskBenchOp op);
+};
+
+#endif // TASK_BENCH_H
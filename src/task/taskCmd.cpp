@@ -11,7 +11,11 @@
 #include <iomanip>
 #include "taskMgr.h"
 #include "taskCmd.h"
+#include "taskOut.h"
+#include "taskBench.h"
+#include "taskBatch.h"
 #include "util.h"
+#include "myStats.h"
 
 using namespace std;
 
@@ -24,7 +28,12 @@ initTaskCmd()
          cmdMgr->regCmd("TASKNew", 5, new TaskNewCmd) &&
          cmdMgr->regCmd("TASKRemove", 5, new TaskRemoveCmd) &&
          cmdMgr->regCmd("TASKQuery", 5, new TaskQueryCmd) &&
-         cmdMgr->regCmd("TASKAssign", 5, new TaskAssignCmd)
+         cmdMgr->regCmd("TASKAssign", 5, new TaskAssignCmd) &&
+         cmdMgr->regCmd("TASKOutput", 5, new TaskOutputCmd) &&
+         cmdMgr->regCmd("TASKBench", 5, new TaskBenchCmd) &&
+         cmdMgr->regCmd("TASKStats", 5, new TaskStatsCmd) &&
+         cmdMgr->regCmd("TASKSAve", 6, new TaskSaveCmd) &&
+         cmdMgr->regCmd("TASKLoad", 5, new TaskLoadCmd)
       )) {
       cerr << "Registering \"task\" commands fails... exiting" << endl;
       return false;
@@ -32,32 +41,63 @@ initTaskCmd()
    return true;
 }
 
+// While batching (see taskBatch.h), the commands on one name are
+// deferred; any other one first lets them catch up.
+static void
+syncBatch()
+{
+   if (taskBatch) taskBatch->sync();
+}
+
+static void
+runNameOp(TaskNameOp op)
+{
+   if (taskBatch) taskBatch->defer(op);
+   else op.run();
+}
+
 //----------------------------------------------------------------------
-//    TASKInit <(size_t numMachines)>
+//    TASKInit <(size_t numMachines)> [-Heap | -Radix]
 //----------------------------------------------------------------------
 CmdExecStatus
 TaskInitCmd::exec(const string& option)
 {
+   TaskOutScope scope("TASKInit");
+   syncBatch();
    // check option
-   string token;
-   if (!CmdExec::lexSingleOption(option, token, false))
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
       return CMD_EXEC_ERROR;
+   if (options.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+   if (options.size() > 2)
+      return CmdExec::errorOption(CMD_OPT_EXTRA, options[2]);
    int numMachines;
-   if (!myStr2Int(token, numMachines) || numMachines <= 0)
-      return CmdExec::errorOption(CMD_OPT_ILLEGAL, token);
+   if (!myStr2Int(options[0], numMachines) || numMachines <= 0)
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[0]);
+   TaskQueueType queue = TASK_QUEUE_HEAP;
+   if (options.size() == 2) {
+      if (myStrNCmp("-Radix", options[1], 2) == 0)
+         queue = TASK_QUEUE_RADIX;
+      else if (myStrNCmp("-Heap", options[1], 2) != 0)
+         return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[1]);
+   }
+   ostream& os = taskOut.os();
    if (taskMgr) {
-      cout << "Warning: Deleting task manager..." << endl;
+      if (taskOut.enabled())
+         os << "Warning: Deleting task manager..." << endl;
       delete taskMgr;
    }
-   taskMgr = new TaskMgr(numMachines);
-   cout << "Task manager is initialized (" << numMachines << ")" << endl;
+   taskMgr = new TaskMgr(numMachines, queue);
+   if (taskOut.enabled())
+      os << "Task manager is initialized (" << numMachines << ")" << endl;
    return CMD_EXEC_DONE;
 }
 
 void
 TaskInitCmd::usage(ostream& os) const
 {
-   os << "Usage: TASKInit <(size_t numMachines)>" << endl;
+   os << "Usage: TASKInit <(size_t numMachines)> [-Heap | -Radix]" << endl;
 }
 
 void
@@ -74,6 +114,7 @@ TaskInitCmd::help() const
 CmdExecStatus
 TaskNewCmd::exec(const string& option)
 {
+   TaskOutScope scope("TASKNew");
    if (!taskMgr) {
       cerr << "Error: task manager is not initialized!" << endl;
       return CMD_EXEC_ERROR;
@@ -117,13 +158,17 @@ TaskNewCmd::exec(const string& option)
    }
 
    if (doRandom) {
+      syncBatch();
       taskMgr->add(numMachines);
-      cout << "... " << numMachines << " new task nodes are added." << endl;
+      if (taskOut.enabled()) {
+         taskOut.os() << "... " << numMachines
+                      << " new task nodes are added.";
+         taskOut.endSummary();
+      }
    }
    else { // doName
       assert(doName); 
-      if (!taskMgr->add(name, load))
-         cerr << "Error: Task node (" << name << ") already exists.\n";
+      runNameOp(TaskNameOp(TaskNameOp::NEW, name, load));
    }
    return CMD_EXEC_DONE;
 }
@@ -143,42 +188,64 @@ TaskNewCmd::help() const
 }
 
 //----------------------------------------------------------------------
-//    TASKRemove <-Random (size_t numMachines) | -Name (string name)>
+//    TASKRemove <-Random (size_t numMachines) [-Batch] |
+//                -Name (string name)>
 //----------------------------------------------------------------------
 CmdExecStatus
 TaskRemoveCmd::exec(const string& option)
 {
+   TaskOutScope scope("TASKRemove");
    if (!taskMgr) {
       cerr << "Error: task manager is not initialized!" << endl;
       return CMD_EXEC_ERROR;
    }
    // check option
    vector<string> options;
-   if (!CmdExec::lexOptions(option, options, 2))
+   if (!CmdExec::lexOptions(option, options))
       return CMD_EXEC_ERROR;
+   if (options.size() < 2)
+      return CmdExec::errorOption(CMD_OPT_MISSING,
+                                  options.empty()? "": options[0]);
 
    if (myStrNCmp("-Random", options[0], 2) == 0) {
       int numMachines;
       if (!myStr2Int(options[1], numMachines) || numMachines <= 0)
          return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[1]);
+      bool batch = false;
+      if (options.size() > 2) {
+         if (myStrNCmp("-Batch", options[2], 2) != 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[2]);
+         if (options.size() > 3)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[3]);
+         batch = true;
+      }
+      syncBatch();
       int n = taskMgr->size();
       if (numMachines < n) {
-         taskMgr->remove(numMachines);
-         cout << "... " << numMachines << " task nodes are removed." << endl;
+         taskMgr->remove(numMachines, batch);
+         if (taskOut.enabled()) {
+            taskOut.os() << "... " << numMachines
+                         << " task nodes are removed.";
+            taskOut.endSummary();
+         }
       }
       else {
          taskMgr->clear();
          if (numMachines > n)
             cerr << "Warning: specified number (" << numMachines << ") is"
                  << " greater than the number of task nodes!!" << endl;
-         cout << "... All the task nodes are removed." << endl;
+         if (taskOut.enabled()) {
+            taskOut.os() << "... All the task nodes are removed.";
+            taskOut.endSummary();
+         }
       }
    }
    else if (myStrNCmp("-Name", options[0], 2) == 0) {
+      if (options.size() > 2)
+         return CmdExec::errorOption(CMD_OPT_EXTRA, options[2]);
       if (!isValidVarName(options[1]))
          return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[1]);
-      if (!taskMgr->remove(options[1]))
-         cerr << "Error: Task node (" << options[1] << ") does not exist.\n";
+      runNameOp(TaskNameOp(TaskNameOp::REMOVE, options[1]));
    }
    else
       return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[0]);
@@ -189,7 +256,7 @@ TaskRemoveCmd::exec(const string& option)
 void
 TaskRemoveCmd::usage(ostream& os) const
 {
-   os << "Usage: TASKRemove <-Random (size_t numMachines) |"
+   os << "Usage: TASKRemove <-Random (size_t numMachines) [-Batch] |"
       << " -Name (string name)>" << endl;
 }
 
@@ -206,6 +273,7 @@ TaskRemoveCmd::help() const
 CmdExecStatus
 TaskQueryCmd::exec(const string& option)
 {
+   TaskOutScope scope("TASKQuery");
    if (!taskMgr) {
       cerr << "Error: task manager is not initialized!" << endl;
       return CMD_EXEC_ERROR;
@@ -214,27 +282,32 @@ TaskQueryCmd::exec(const string& option)
    string token;
    if (!CmdExec::lexSingleOption(option, token, false))
       return CMD_EXEC_ERROR;
+   if (!isValidVarName(token))
+      syncBatch();
+   ostream& os = taskOut.os();
+   bool out = taskOut.enabled();
    if (myStrNCmp("-HAsh", token, 3) == 0) {
-      taskMgr->printAllHash();
-      cout << "Number of tasks: " << taskMgr->size() << endl;
+      if (out) {
+         taskMgr->printAllHash();
+         os << "Number of tasks: " << taskMgr->size() << endl;
+      }
    }
    // hidden option
    else if (myStrNCmp("-HEap", token, 3) == 0) {
-      taskMgr->printAllHeap();
-      cout << "Number of tasks: " << taskMgr->size() << endl;
+      if (out) {
+         taskMgr->printAllHeap();
+         os << "Number of tasks: " << taskMgr->size() << endl;
+      }
    }
    else if (myStrNCmp("-MINimum", token, 4) == 0) {
       if (taskMgr->empty()) {
          cerr << "Error: task manager is empty!" << endl;
          return CMD_EXEC_ERROR;
       }
-      cout << "Min task node: " << taskMgr->min() << endl;
-   }
-   else if (isValidVarName(token)) {
-      TaskNode n(token, 0);
-      if (taskMgr->query(n)) { cout << "Query succeeds: " << n << endl; }
-      else cerr << "Query fails!" << endl;
+      if (out) os << "Min task node: " << taskMgr->min() << endl;
    }
+   else if (isValidVarName(token))
+      runNameOp(TaskNameOp(TaskNameOp::QUERY, token));
    else
       return CmdExec::errorOption(CMD_OPT_ILLEGAL, token);
    return CMD_EXEC_DONE;
@@ -260,6 +333,8 @@ TaskQueryCmd::help() const
 CmdExecStatus
 TaskAssignCmd::exec(const string& option)
 {
+   TaskOutScope scope("TASKAssign");
+   syncBatch();
    if (!taskMgr) {
       cerr << "Error: task manager is not initialized!" << endl;
       return CMD_EXEC_ERROR;
@@ -292,13 +367,27 @@ TaskAssignCmd::exec(const string& option)
    if (load == -1)
       return CmdExec::errorOption(CMD_OPT_MISSING, "");
 
+   ostream& os = taskOut.os();
    if (!doRepeat) repeats = 1;
-   for (int i = 0; i < repeats; ++i) {
-      if (taskMgr->assign(load))
-         cout << "Task assignment succeeds..." << endl
-              << "Updating min: " << taskMgr->min() << endl;
-      else cerr << "Task assignment fails!" << endl;
+   if (repeats == 1 || taskOut.verbose()) {
+      // one line pair per assignment, with the min after each of them
+      for (int i = 0; i < repeats; ++i) {
+         if (taskMgr->assign(load)) {
+            if (taskOut.enabled())
+               os << "Task assignment succeeds..." << endl
+                  << "Updating min: " << taskMgr->min() << endl;
+         }
+         else cerr << "Task assignment fails!" << endl;
+      }
+   }
+   else if (taskMgr->assignBatch(load, repeats)) {
+      if (taskOut.enabled()) {
+         os << "Task assignment succeeds... (" << repeats << " times)";
+         taskOut.endSummary();
+         os << "Updating min: " << taskMgr->min() << endl;
+      }
    }
+   else cerr << "Task assignment fails!" << endl;
    return CMD_EXEC_DONE;
 }
 
@@ -315,3 +404,293 @@ TaskAssignCmd::help() const
         << "Assign load to the minimum task node(s)\n";
 }
 
+
+//----------------------------------------------------------------------
+//    TASKOutput [-Normal | -Buffered | -Summary | -Quiet]
+//----------------------------------------------------------------------
+CmdExecStatus
+TaskOutputCmd::exec(const string& option)
+{
+   syncBatch();
+   // check option
+   string token;
+   if (!CmdExec::lexSingleOption(option, token))
+      return CMD_EXEC_ERROR;
+   static const char* names[] = { "normal", "buffered", "summary", "quiet" };
+   if (token.empty()) {
+      cout << "Task output mode: " << names[taskOut.mode()] << endl;
+      return CMD_EXEC_DONE;
+   }
+   if (myStrNCmp("-Normal", token, 2) == 0)
+      taskOut.setMode(TASK_OUT_NORMAL);
+   else if (myStrNCmp("-Buffered", token, 2) == 0)
+      taskOut.setMode(TASK_OUT_BUFFERED);
+   else if (myStrNCmp("-Summary", token, 2) == 0)
+      taskOut.setMode(TASK_OUT_SUMMARY);
+   else if (myStrNCmp("-Quiet", token, 2) == 0)
+      taskOut.setMode(TASK_OUT_QUIET);
+   else
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, token);
+   return CMD_EXEC_DONE;
+}
+
+void
+TaskOutputCmd::usage(ostream& os) const
+{
+   os << "Usage: TASKOutput [-Normal | -Buffered | -Summary | -Quiet]"
+      << endl;
+}
+
+void
+TaskOutputCmd::help() const
+{
+   cout << setw(15) << left << "TASKOutput: "
+        << "Set the output mode of task commands" << endl;
+}
+
+//----------------------------------------------------------------------
+//    TASKBench <(size_t numOps)> [-Mix (size_t new) (size_t remove)
+//              (size_t query) (size_t assign)] [-SKew (size_t skew)]
+//              [-SEed (size_t seed)]
+//----------------------------------------------------------------------
+// Runs numOps random operations on the task manager (see taskBench.h)
+// with no per-node output, then reports the throughput, the latency
+// percentiles of each operation type and the time and memory used.
+// The weights of -Mix default to 1 1 1 1; -SKew defaults to 0 (uniform).
+// -SEed seeds the generator of the run, so the same seed gives the same
+// run; without it, the seed is drawn from rnGen.
+//
+CmdExecStatus
+TaskBenchCmd::exec(const string& option)
+{
+   TaskOutScope scope("TASKBench");
+   syncBatch();
+   if (!taskMgr) {
+      cerr << "Error: task manager is not initialized!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+   if (options.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+
+   int numOps = -1, skew = 0, seed = -1;
+   bool doMix = false;
+   size_t mix[TASK_BENCH_TOT];
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-Mix", options[i], 2) == 0) {
+         if (doMix) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         doMix = true;
+         for (size_t j = 0; j < TASK_BENCH_TOT; ++j) {
+            if (++i >= n)
+               return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+            int w;
+            if (!myStr2Int(options[i], w) || w < 0)
+               return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+            mix[j] = w;
+         }
+      }
+      else if (myStrNCmp("-SKew", options[i], 3) == 0 ||
+               myStrNCmp("-SEed", options[i], 3) == 0) {
+         if (++i >= n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         int v;
+         if (!myStr2Int(options[i], v) || v < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         if (myStrNCmp("-SKew", options[i-1], 3) == 0) skew = v;
+         else seed = v;
+      }
+      else {
+         if (numOps != -1)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (!myStr2Int(options[i], numOps) || numOps <= 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+      }
+   }
+   if (numOps == -1)
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+
+   if (doMix) {
+      // the op is drawn by a 32-bit FastRandomNumGen
+      size_t sum = 0;
+      for (size_t j = 0; j < TASK_BENCH_TOT; ++j) sum += mix[j];
+      if (sum > UINT32_MAX) {
+         cerr << "Error: the weights of -Mix add up to more than "
+              << UINT32_MAX << "!" << endl;
+         return CMD_EXEC_ERROR;
+      }
+   }
+   TaskBench bench(*taskMgr);
+   if (doMix && !bench.setMix(mix)) {
+      cerr << "Error: all the weights of -Mix are 0!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   bench.setSkew(skew);
+   if (seed != -1) bench.setSeed(seed);
+
+   MyUsage usage;
+   TaskOutMode mode = taskOut.mode();
+   taskOut.setMode(TASK_OUT_QUIET);
+   bench.run(numOps);
+   taskOut.setMode(mode);
+
+   if (taskOut.enabled()) {
+      bench.report(taskOut.os());
+      taskOut.flush();
+      usage.report(true, true);
+   }
+   return CMD_EXEC_DONE;
+}
+
+void
+TaskBenchCmd::usage(ostream& os) const
+{
+   os << "Usage: TASKBench <(size_t numOps)> [-Mix (size_t new) "
+      << "(size_t remove)\n"
+      << "                 (size_t query) (size_t assign)] "
+      << "[-SKew (size_t skew)]\n"
+      << "                 [-SEed (size_t seed)]" << endl;
+}
+
+void
+TaskBenchCmd::help() const
+{
+   cout << setw(15) << left << "TASKBench: "
+        << "Run a random workload and report its timing" << endl;
+}
+
+//----------------------------------------------------------------------
+//    TASKStats [-Reset]
+//----------------------------------------------------------------------
+// Prints the latency histograms of the TaskMgr, hash and heap calls and
+// the hash probe / heap sift depth counts gathered so far, or empties
+// them with -Reset. Only available when built with -DMY_STATS (see
+// make.task); otherwise nothing is gathered at all.
+//
+CmdExecStatus
+TaskStatsCmd::exec(const string& option)
+{
+   TaskOutScope scope("TASKStats");
+   syncBatch();
+   // check option
+   string token;
+   if (!CmdExec::lexSingleOption(option, token))
+      return CMD_EXEC_ERROR;
+   if (!token.empty() && myStrNCmp("-Reset", token, 2) != 0)
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, token);
+#ifdef MY_STATS
+   if (!token.empty())
+      myStats.reset();
+   else if (taskOut.enabled())
+      myStats.report(taskOut.os());
+   return CMD_EXEC_DONE;
+#else
+   cerr << "Error: statistics are not compiled in (use -DMY_STATS)!"
+        << endl;
+   return CMD_EXEC_ERROR;
+#endif
+}
+
+void
+TaskStatsCmd::usage(ostream& os) const
+{
+   os << "Usage: TASKStats [-Reset]" << endl;
+}
+
+void
+TaskStatsCmd::help() const
+{
+   cout << setw(15) << left << "TASKStats: "
+        << "Report or reset the operation statistics" << endl;
+}
+
+//----------------------------------------------------------------------
+//    TASKSAve <(string fileName)>
+//----------------------------------------------------------------------
+// Writes a binary snapshot of the task manager (see taskSnap.cpp).
+//
+CmdExecStatus
+TaskSaveCmd::exec(const string& option)
+{
+   TaskOutScope scope("TASKSAve");
+   syncBatch();
+   if (!taskMgr) {
+      cerr << "Error: task manager is not initialized!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   string token;
+   if (!CmdExec::lexSingleOption(option, token, false))
+      return CMD_EXEC_ERROR;
+   string err;
+   if (!taskMgr->save(token, err)) {
+      cerr << "Error: " << err << "!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   if (taskOut.enabled())
+      taskOut.os() << "Task manager is saved to \"" << token << "\" ("
+                   << taskMgr->size() << ")" << endl;
+   return CMD_EXEC_DONE;
+}
+
+void
+TaskSaveCmd::usage(ostream& os) const
+{
+   os << "Usage: TASKSAve <(string fileName)>" << endl;
+}
+
+void
+TaskSaveCmd::help() const
+{
+   cout << setw(15) << left << "TASKSAve: "
+        << "Save the task manager to a snapshot file" << endl;
+}
+
+//----------------------------------------------------------------------
+//    TASKLoad <(string fileName)>
+//----------------------------------------------------------------------
+// Replaces the task manager by the one in a snapshot of TASKSAve; the
+// current one is kept if the file cannot be loaded.
+//
+CmdExecStatus
+TaskLoadCmd::exec(const string& option)
+{
+   TaskOutScope scope("TASKLoad");
+   syncBatch();
+   // check option
+   string token;
+   if (!CmdExec::lexSingleOption(option, token, false))
+      return CMD_EXEC_ERROR;
+   string err;
+   TaskMgr* m = TaskMgr::load(token, err);
+   if (!m) {
+      cerr << "Error: " << err << "!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   ostream& os = taskOut.os();
+   if (taskMgr) {
+      if (taskOut.enabled())
+         os << "Warning: Deleting task manager..." << endl;
+      delete taskMgr;
+   }
+   taskMgr = m;
+   if (taskOut.enabled())
+      os << "Task manager is loaded from \"" << token << "\" ("
+         << taskMgr->size() << ")" << endl;
+   return CMD_EXEC_DONE;
+}
+
+void
+TaskLoadCmd::usage(ostream& os) const
+{
+   os << "Usage: TASKLoad <(string fileName)>" << endl;
+}
+
+void
+TaskLoadCmd::help() const
+{
+   cout << setw(15) << left << "TASKLoad: "
+        << "Load the task manager from a snapshot file" << endl;
+}
@@ -16,6 +16,11 @@ CmdClass(TaskNewCmd);
 CmdClass(TaskRemoveCmd);
 CmdClass(TaskQueryCmd);
 CmdClass(TaskAssignCmd);
+CmdClass(TaskOutputCmd);
+CmdClass(TaskBenchCmd);
+CmdClass(TaskStatsCmd);
+CmdClass(TaskSaveCmd);
+CmdClass(TaskLoadCmd);
 
 #endif // TASK_CMD_H
 
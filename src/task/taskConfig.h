@@ -0,0 +1,35 @@
+/****************************************************************************
+  FileName     [ taskConfig.h ]
+  PackageName  [ task ]
+  Synopsis     [ Define the build options of the task manager ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef TASK_CONFIG_H
+#define TASK_CONFIG_H
+
+//----------------------------------------------------------------------
+//    Build options of TaskMgr
+//----------------------------------------------------------------------
+// These change the layout of TaskMgr, so every file that includes
+// taskMgr.h (the task, main and bench packages) must see the same ones.
+// Set them here, not in the PKGFLAG of one package; a -D on the make
+// command line (e.g. make PKGFLAG=-DTASK_OPEN_HASH) reaches every
+// package and works too.
+//
+// TASK_OPEN_HASH      the tasks in OpenHashSet instead of HashSet
+// TASK_LEGACY_HASH    the hash function of the reference program
+// TASK_HEAP_ARITY     the arity of TaskHeap
+// TASK_INDIRECT_HEAP  TaskHeap compares the loads in _tasks (IdxMinHeap)
+//                     instead of keeping a copy of them (KeyMinHeap)
+//
+//#define TASK_OPEN_HASH
+//#define TASK_LEGACY_HASH
+//#define TASK_INDIRECT_HEAP
+
+#ifndef TASK_HEAP_ARITY
+#define TASK_HEAP_ARITY  4
+#endif
+
+#endif // TASK_CONFIG_H
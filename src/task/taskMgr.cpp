@@ -8,10 +8,13 @@
 
 #include <iostream>
 #include <string>
+#include <algorithm>
 #include <cassert>
 #include "taskMgr.h"
+#include "taskOut.h"
 #include "rnGen.h"
 #include "util.h"
+#include "myStats.h"
 
 using namespace std;
 
@@ -20,19 +23,20 @@ TaskMgr *taskMgr = 0;
 // BEGIN: DO NOT CHANGE THIS PART
 TaskNode::TaskNode() 
 {
-   _name.resize(NAME_LEN);
+   char name[NAME_LEN];
    for (int i = 0; i < NAME_LEN; ++i)
-      _name[i] = 'a' + rnGen(26);
+      name[i] = 'a' + rnGen(26);
+   _name = TaskName(name, NAME_LEN);
    _load = rnGen(LOAD_RN);
 }
 
-size_t
-TaskNode::operator () () const 
+// not the same nodes as TaskNode(), and the load is below LOAD_RN
+TaskNode::TaskNode(FastRandomNumGen& rn)
 {
-   size_t k = 0, n = (_name.length() <= 5)? _name.length(): 5;
-   for (size_t i = 0; i < n; ++i)
-      k ^= (_name[i] << (i*6));
-   return k;
+   char name[NAME_LEN];
+   rn.fill(name, NAME_LEN, 'a', 26);
+   _name = TaskName(name, NAME_LEN);
+   _load = rn(LOAD_RN);
 }
 
 ostream& operator << (ostream& os, const TaskNode& n)
@@ -40,26 +44,81 @@ ostream& operator << (ostream& os, const TaskNode& n)
    return os << "(" << n._name << ", " << n._load << ")";
 }
 
-TaskMgr::TaskMgr(size_t nMachines)
-: _taskHeap(nMachines), _taskHash(getHashSize(nMachines)) { }
+TaskMgr::TaskMgr(size_t nMachines, TaskQueueType q)
+: _queueType(q),
+  _taskHash(getHashSize(nMachines), TaskHasher(&_tasks), TaskEqual(&_tasks),
+            TaskAlloc(&_arena)),
+  _silent(false)
+{
+   if (q == TASK_QUEUE_RADIX)
+      _taskHeap.reset(new TaskQueueOf<TaskRadix>(&_tasks, nMachines));
+   else
+      _taskHeap.reset(new TaskQueueOf<TaskHeap>(&_tasks, nMachines));
+   _tasks.reserve(nMachines);
+}
 
 void
 TaskMgr::clear()
 {
-   for (size_t i = 0, n = size(); i < n; ++i)
-      cout << "Task node removed: " << _taskHeap[i] << endl;
-   _taskHeap.clear(); _taskHash.clear();
+   if (verbose())
+      for (size_t i = 0, n = size(); i < n; ++i)
+         taskOut.os() << "Task node removed: " << _tasks[(*_taskHeap)[i]]
+                      << endl;
+   _taskHeap->clear();
+   // the hash is all in _arena: drop the arena at once, then start over
+   // with as many buckets
+   size_t b = _taskHash.numBuckets();
+   _taskHash.release();
+   _arena.release();
+   if (b != 0) _taskHash.init(b);
+   _tasks.clear(); _freeTasks.clear();
 }
 
+// Remove nMachines (< size()) random nodes.
+// By default each victim is drawn from the queue slots and deleted in
+// turn, as the reference program does. With 'batch', all the victims are
+// picked first, so the queue is fixed only once; the victims differ.
 void
-TaskMgr::remove(size_t nMachines)
+TaskMgr::remove(size_t nMachines, bool batch)
 {        
-   for (size_t i = 0, n = nMachines; i < n; ++i) {
-      size_t j = rnGen(size());
-      assert(_taskHash.remove(_taskHeap[j]));
-      cout << "Task node removed: " << _taskHeap[j] << endl;
-      _taskHeap.delData(j);
+   MY_STATS_LATENCY("TaskMgr::remove -Random");
+   if (!batch) {
+      for (size_t i = 0, n = nMachines; i < n; ++i) {
+         size_t j = rnGen(size());
+         uint32_t t = (*_taskHeap)[j];
+         bool found = _taskHash.remove(t);
+         assert(found);
+         if (verbose())
+            taskOut.os() << "Task node removed: " << _tasks[t] << endl;
+         _taskHeap->delData(j);
+         freeTask(t);
+      }
+      return;
+   }
+   size_t n = size();
+   assert(nMachines < n);
+   // mark the nodes that go, or the ones that stay if they are fewer
+   bool markStay = nMachines * 2 > n;
+   vector<bool> marked(n, false);
+   for (size_t k = markStay? n - nMachines: nMachines; k != 0; ) {
+      size_t j = rnGen(n);
+      if (!marked[j]) { marked[j] = true; --k; }
+   }
+   vector<uint32_t> victims;
+   victims.reserve(nMachines);
+   for (size_t j = 0; j < n; ++j)
+      if (marked[j] != markStay)
+         victims.push_back((*_taskHeap)[j]);
+
+   for (size_t i = 0; i < victims.size(); ++i) {
+      bool found = _taskHash.remove(victims[i]);
+      assert(found);
+      if (verbose())
+         taskOut.os() << "Task node removed: " << _tasks[victims[i]] << endl;
    }
+   _taskHeap->delHandles(victims);
+   for (size_t i = 0; i < victims.size(); ++i)
+      freeTask(victims[i]);
 }
 
 // return true if TaskNode is successfully removed
@@ -67,14 +126,13 @@ TaskMgr::remove(size_t nMachines)
 bool
 TaskMgr::remove(const string& s)
 {
-   TaskNode n(s, 0);
-   if (!_taskHash.remove(n)) return false;
-   for (size_t i = 0, m = size(); i < m; ++i)
-      if (_taskHeap[i] == n) {
-         cout << "Task node removed: " << _taskHeap[i] << endl;
-         _taskHeap.delData(i);
-         break;
-      }
+   MY_STATS_LATENCY("TaskMgr::remove");
+   uint32_t t;
+   if (!_taskHash.removeKey(TaskName(s), &t)) return false;
+   if (verbose())
+      taskOut.os() << "Task node removed: " << _tasks[t] << endl;
+   _taskHeap->delHandle(t);
+   freeTask(t);
    return true;
 }
 // END: DO NOT CHANGE THIS PART
@@ -86,15 +144,25 @@ void
 TaskMgr::add(size_t nMachines)
 {
    // TODO... done? 1230 0144
-  for( size_t i = 0; i < nMachines; ){
-    const auto tmp = TaskNode();
-    if( _taskHash.insert( tmp ) ){
-      _taskHeap.insert( tmp) ;
-      ++i;
-      cout << "Task node inserted: (" << tmp.getName() << ", "
-        << tmp.getLoad() << ')' << endl;
-    }
+  MY_STATS_LATENCY( "TaskMgr::add -Random" );
+  // hash all the new nodes first (dropping duplicated names), then
+  // build the queue once; same nodes in the same order as adding them
+  // one by one.
+  vector<uint32_t> added;
+  added.reserve( nMachines );
+  _taskHash.reserve( size() + nMachines );
+  while( added.size() < nMachines ){
+    uint32_t t = newTask( TaskNode() );
+    if( _taskHash.insert( t ) )
+      added.push_back( t );
+    else
+      freeTask( t );
   }
+  _taskHeap->insertAll( added );
+  if( verbose() )
+    for( size_t i = 0; i < added.size(); ++i )
+      taskOut.os() << "Task node inserted: (" << _tasks[added[i]].getName()
+        << ", " << _tasks[added[i]].getLoad() << ')' << endl;
 }
 
 // return true if TaskNode is successfully inserted
@@ -103,51 +171,179 @@ TaskMgr::add(size_t nMachines)
 TaskMgr::add(const string& s, size_t l)
 {
   // TODO... done 1230 1630
-  TaskNode tmp(s,l);
-  if( _taskHash.insert( tmp ) )
+  MY_STATS_LATENCY( "TaskMgr::add" );
+  uint32_t t = newTask( TaskNode(s,l) );
+  if( _taskHash.insert( t ) )
   {
-    _taskHeap.insert( tmp );
-    cout << "Task node inserted: (" << tmp.getName() << ", "
-      << tmp.getLoad() << ')' << endl;
+    _taskHeap->insert( t );
+    if( verbose() )
+      taskOut.os() << "Task node inserted: (" << _tasks[t].getName() << ", "
+        << _tasks[t].getLoad() << ')' << endl;
     return true;
   }
+  freeTask( t );
   return false;
 }
 
+// same as add(s, l), for a name known not to be in taskMgr (e.g. by
+// TaskBatch); so it is not looked for
+void
+TaskMgr::addNew(const string& s, size_t l)
+{
+  MY_STATS_LATENCY( "TaskMgr::add" );
+  uint32_t t = newTask( TaskNode(s,l) );
+  _taskHash.insertNew( t );
+  _taskHeap->insert( t );
+  if( verbose() )
+    taskOut.os() << "Task node inserted: (" << _tasks[t].getName() << ", "
+      << _tasks[t].getLoad() << ')' << endl;
+}
+
 // Assign the min task node with 'l' extra load.
 // That is, the load of the min node will be increased by 'l'.
 // The min node in the heap should be updated accordingly.
-// The corresponding node in the hash should be updated, too.
+// (The hash only holds the index of the node; nothing to update there.)
 // return false if taskMgr is empty
 // otherwise, return true.
   bool
 TaskMgr::assign(size_t l)
 {
   // TODO... done 1230 1640
+  MY_STATS_LATENCY( "TaskMgr::assign" );
   if( empty() )
     return false;
 
-  TaskNode tmp = _taskHeap.min();
-  tmp += l;
-  _taskHash.update( tmp );
-  _taskHeap.delMin();
-  _taskHeap.insert( tmp );
+  // the load only goes up, so sift the root down in place
+  uint32_t t = _taskHeap->min();
+  _tasks[t] += l;
+  _taskHeap->updateKey( _taskHeap->slot( t ) );
 
   return true;
 }
 
+// Same as calling assign(l) for 'repeats' times.
+// Every assignment goes to the current min, so the loads the nodes are
+// picked at are exactly the 'repeats' smallest values of
+// { load + j*l | j >= 0 } over all the nodes. Find the greatest such
+// value V by binary search, give every node its whole share at once,
+// then fix the heap once.
+// With the radix queue, nodes of equal load may be picked in another
+// order than by assign().
+// return false if taskMgr is empty
+// otherwise, return true.
+  bool
+TaskMgr::assignBatch(size_t l, size_t repeats)
+{
+  MY_STATS_LATENCY( "TaskMgr::assign -Repeat" );
+  if( empty() )
+    return false;
+  if( repeats == 0 || l == 0 )
+    return true;
+
+  // the min node alone could take all of them, which bounds V.
+  size_t lo = min().getLoad(), hi = lo + (repeats-1)*l;
+  vector<size_t> slots;
+  _taskHeap->collect( hi, slots );
+  // the binary search below scans the loads many times; keep them dense
+  vector<uint32_t> hs( slots.size() );
+  vector<size_t> loads( slots.size() );
+  for( size_t i = 0; i < slots.size(); ++i )
+  {
+    hs[i] = (*_taskHeap)[slots[i]];
+    loads[i] = _tasks[hs[i]].getLoad();
+  }
+
+  // number of values not greater than v, saturated at 'repeats'
+  auto count = [&]( size_t v ) {
+    size_t c = 0;
+    for( size_t i = 0; i < loads.size() && c < repeats; ++i )
+      if( loads[i] <= v ) c += (v-loads[i])/l + 1;
+    return c;
+  };
+  while( lo < hi ) {
+    size_t mid = lo + (hi-lo)/2;
+    if( count( mid ) < repeats ) lo = mid + 1;
+    else hi = mid;
+  }
+  const size_t v = lo;
+
+  // all the values below V are taken; V itself only 'extra' times, by
+  // the nodes that reach it with the smallest indices (see TaskHeap).
+  size_t below = 0;
+  vector<uint32_t> atV;
+  for( size_t i = 0; i < loads.size(); ++i )
+    if( loads[i] <= v ) {
+      below += (v-loads[i])/l + ((v-loads[i])%l != 0);
+      if( (v-loads[i])%l == 0 ) atV.push_back( hs[i] );
+    }
+  const size_t extra = repeats - below;
+  uint32_t last = 0;      // the greatest index that takes V
+  if( extra != 0 ) {
+    nth_element( atV.begin(), atV.begin() + (extra-1), atV.end() );
+    last = atV[extra-1];
+  }
+
+  vector<size_t> touched;
+  for( size_t i = 0; i < slots.size(); ++i ) {
+    size_t a = loads[i];
+    if( a > v ) continue;
+    size_t k = (v-a)/l;
+    if( (v-a)%l != 0 ) ++k;
+    else if( extra != 0 && hs[i] <= last ) ++k;
+    if( k == 0 ) continue;
+    _tasks[hs[i]] += k*l;
+    touched.push_back( slots[i] );
+  }
+  _taskHeap->increaseKeys( touched );
+  return true;
+}
+
+// return true and copy the node into n if there is a node named
+// n.getName(); return false otherwise.
+bool
+TaskMgr::query(TaskNode& n) const
+{
+  MY_STATS_LATENCY( "TaskMgr::query" );
+  const uint32_t* p = _taskHash.findKey( n.getName() );
+  if( p == nullptr )
+    return false;
+  n = _tasks[*p];
+  return true;
+}
+
+bool
+TaskMgr::verbose() const
+{
+  return !_silent && taskOut.verbose();
+}
+
+// put n into a free entry of _tasks; return its index
+uint32_t
+TaskMgr::newTask(const TaskNode& n)
+{
+  if( _freeTasks.empty() )
+  {
+    _tasks.push_back( n );
+    return _tasks.size()-1;
+  }
+  uint32_t t = _freeTasks.back();
+  _freeTasks.pop_back();
+  _tasks[t] = n;
+  return t;
+}
+
 // WARNING: DO NOT CHANGE THESE TWO FUNCTIONS!!
 void
 TaskMgr::printAllHash() const 
 {
-  HashSet<TaskNode>::iterator hi = _taskHash.begin();
+  TaskHash::iterator hi = _taskHash.begin();
   for (; hi != _taskHash.end(); ++hi)
-    cout << *hi << endl;
+    taskOut.os() << _tasks[*hi] << endl;
 }
 
 void
 TaskMgr::printAllHeap() const
 {
   for (size_t i = 0, n = size(); i < n; ++i)
-    cout << _taskHeap[i] << endl;
+    taskOut.os() << _tasks[(*_taskHeap)[i]] << endl;
 }
@@ -11,60 +11,249 @@
 
 #include <iostream>
 #include <string>
+#include <memory>
 #include "myHashSet.h"
+#include "myOpenHashSet.h"
 #include "myMinHeap.h"
+#include "myRadixHeap.h"
+#include "myArena.h"
+#include "taskConfig.h"
+#include "taskName.h"
 
 using namespace std;
 
+class FastRandomNumGen;
+
 class TaskNode
 {
 #define NAME_LEN  6
 #define LOAD_RN   20000
 
 public:
-   TaskNode();
+   TaskNode();                       // random, from rnGen
+   TaskNode(FastRandomNumGen& rn);   // random, from rn
    TaskNode(const string& n, size_t l) : _name(n), _load(l) {}
-   ~TaskNode() {}
+   TaskNode(const TaskName& n, size_t l) : _name(n), _load(l) {}
 
    void operator += (size_t l) { _load += l; }
    bool operator == (const TaskNode& n) const { return _name == n._name; }
    bool operator < (const TaskNode& n) const { return _load < n._load; }
-   size_t operator () () const;
+   size_t operator () () const { return _name.hash(); }
+   size_t legacyHash() const { return _name.legacyHash(); }
 
-   const string& getName() const { return _name; }
+   const TaskName& getName() const { return _name; }
    size_t getLoad() const { return _load; }
 
    friend ostream& operator << (ostream& os, const TaskNode& n);
 
 private:
-   string   _name;
-   size_t   _load;
+   TaskName   _name;
+   size_t     _load;
+};
+
+//----------------------------------------------------------------------
+//    Policies of the heap and the hash in TaskMgr
+//----------------------------------------------------------------------
+// TaskMgr keeps every task node once, in its "_tasks" array; the heap and
+// the hash only hold 32-bit indices into it. These policies compare and
+// hash the nodes behind the indices. The hash can also be searched by
+// TaskName directly.
+//
+class TaskRef
+{
+public:
+   TaskRef(const vector<TaskNode>* t = 0) : _tasks(t) {}
+
+protected:
+   const TaskNode& node(uint32_t i) const { return (*_tasks)[i]; }
+
+private:
+   const vector<TaskNode>*   _tasks;
+};
+
+struct TaskLess : public TaskRef
+{
+   TaskLess(const vector<TaskNode>* t = 0) : TaskRef(t) {}
+   bool operator () (uint32_t a, uint32_t b) const {
+      return node(a) < node(b); }
+};
+
+// the key of KeyMinHeap
+struct TaskLoad : public TaskRef
+{
+   typedef size_t Key;
+   TaskLoad(const vector<TaskNode>* t = 0) : TaskRef(t) {}
+   size_t operator () (uint32_t i) const { return node(i).getLoad(); }
+};
+
+// Define TASK_LEGACY_HASH (see taskConfig.h) to hash the names with
+// the hash function of the reference program, so that "TASKQuery -HAsh"
+// lists the nodes in the same order. It does not reproduce the output of
+// the reference program: TaskHeap breaks the ties of equal loads by task
+// index, unlike the reference heap, so once two nodes have the same load
+// the heap order, and then the loads assigned, may differ.
+struct TaskHasher : public TaskRef
+{
+   TaskHasher(const vector<TaskNode>* t = 0) : TaskRef(t) {}
+   size_t operator () (uint32_t i) const { return (*this)(node(i).getName()); }
+   size_t operator () (const TaskName& n) const {
+#ifdef TASK_LEGACY_HASH
+      return n.legacyHash();
+#else
+      return n.hash();
+#endif
+   }
+};
+
+struct TaskEqual : public TaskRef
+{
+   TaskEqual(const vector<TaskNode>* t = 0) : TaskRef(t) {}
+   bool operator () (uint32_t a, uint32_t b) const {
+      return node(a) == node(b); }
+   bool operator () (uint32_t a, const TaskName& n) const {
+      return node(a).getName() == n; }
+};
+
+// Define TASK_OPEN_HASH to keep the tasks in the open addressing
+// OpenHashSet instead of the chained HashSet.
+// Either one keeps its table, buckets or slots, in the arena of its
+// TaskMgr, so that TaskMgr::clear() drops it all at once. The task queue
+// does not: it is a few large arrays, which seldom grow.
+typedef ArenaAlloc<uint32_t>                          TaskAlloc;
+#ifdef TASK_OPEN_HASH
+typedef OpenHashSet<uint32_t, TaskHasher, TaskEqual, TaskAlloc>  TaskHash;
+#else
+typedef HashSet<uint32_t, TaskHasher, TaskEqual, TaskAlloc>      TaskHash;
+#endif
+
+// TASK_HEAP_ARITY is the arity of the task heap (4 by default).
+// With 4 the tree is half as deep as the binary one, and the keys of the
+// 4 children of a node (size_t, 32 bytes) lie in one cache line (see
+// KeySlots). Whether that pays depends on the machine; compare the
+// KeyMinHeap2/4 and TaskMgr cases of taskBench -HEap.
+// TASK_INDIRECT_HEAP: compare the loads in _tasks instead of keeping a
+// copy of them next to the handles.
+#ifdef TASK_INDIRECT_HEAP
+typedef IdxMinHeap<TaskLess, TASK_HEAP_ARITY>         TaskHeap;
+#else
+typedef KeyMinHeap<TaskLoad, TASK_HEAP_ARITY>         TaskHeap;
+#endif
+typedef RadixHeap<TaskLoad>                           TaskRadix;
+
+//----------------------------------------------------------------------
+//    TaskQueue: the priority queue of TaskMgr
+//----------------------------------------------------------------------
+// Orders the task indices by load. Which one is used is picked at
+// TASKInit: TaskHeap (default) or TaskRadix.
+// A slot is a position 0 ... size()-1 in the queue; slot 0 is the min
+// only in a heap.
+//
+enum TaskQueueType
+{
+   TASK_QUEUE_HEAP,
+   TASK_QUEUE_RADIX
+};
+
+class TaskQueue
+{
+public:
+   virtual ~TaskQueue() {}
+
+   virtual void clear() = 0;
+   virtual uint32_t operator [] (size_t i) const = 0;
+   virtual size_t size() const = 0;
+   virtual size_t slot(uint32_t t) const = 0;
+   virtual uint32_t min() const = 0;
+   virtual void insert(uint32_t t) = 0;
+   virtual void insertAll(const vector<uint32_t>& ts) = 0;
+   virtual void delData(size_t i) = 0;
+   virtual void delHandle(uint32_t t) = 0;
+   virtual void delHandles(const vector<uint32_t>& ts) = 0;
+   virtual void updateKey(size_t i) = 0;
+   virtual void increaseKeys(vector<size_t>& slots) = 0;
+   // the slots of all the tasks with load <= bound
+   virtual void collect(size_t bound, vector<size_t>& slots) const = 0;
+};
+
+template <class Queue>
+class TaskQueueOf : public TaskQueue
+{
+public:
+   TaskQueueOf(const vector<TaskNode>* t, size_t s)
+      : _load(t), _q(typename Queue::Policy(t), s) {}
+
+   void clear() { _q.clear(); }
+   uint32_t operator [] (size_t i) const { return _q[i]; }
+   size_t size() const { return _q.size(); }
+   size_t slot(uint32_t t) const { return _q.slot(t); }
+   uint32_t min() const { return _q.min(); }
+   void insert(uint32_t t) { _q.insert(t); }
+   void insertAll(const vector<uint32_t>& ts) { _q.insertAll(ts); }
+   void delData(size_t i) { _q.delData(i); }
+   void delHandle(uint32_t t) { _q.delHandle(t); }
+   void delHandles(const vector<uint32_t>& ts) { _q.delHandles(ts); }
+   void updateKey(size_t i) { _q.updateKey(i); }
+   void increaseKeys(vector<size_t>& slots) { _q.increaseKeys(slots); }
+   void collect(size_t bound, vector<size_t>& slots) const {
+      _q.collect([&](uint32_t t) { return _load(t) <= bound; }, slots); }
+
+private:
+   TaskLoad   _load;
+   Queue      _q;
 };
 
 class TaskMgr
 {
 public:
-   TaskMgr(size_t nMachines);
+   TaskMgr(size_t nMachines, TaskQueueType q = TASK_QUEUE_HEAP);
    ~TaskMgr() {}
 
    void clear();
 
-   size_t size() const { return _taskHeap.size(); }
-   bool empty() { return size() == 0; }
+   size_t size() const { return _taskHeap->size(); }
+   bool empty() const { return size() == 0; }
 
-   const TaskNode& min() const { return _taskHeap.min(); }
+   const TaskNode& min() const { return _tasks[_taskHeap->min()]; }
+   // the task in slot i of the queue (0 <= i < size()), in no order
+   const TaskNode& operator [] (size_t i) const {
+      return _tasks[(*_taskHeap)[i]]; }
    void add(size_t nMachines);
    bool add(const string&, size_t);
-   void remove(size_t nMachines);
+   void addNew(const string&, size_t);
+   void remove(size_t nMachines, bool batch = false);
    bool remove(const string&);
    bool assign (size_t l);
-   bool query(TaskNode& n) { return _taskHash.query(n); }
+   bool assignBatch (size_t l, size_t repeats);
+   bool query(TaskNode& n) const;
    void printAllHash() const;
    void printAllHeap() const;
 
+   // no per-node output, whatever the TASKOutput mode (e.g. for threads)
+   void setSilent(bool s) { _silent = s; }
+
+   // binary snapshots (see taskSnap.cpp); on failure, return false
+   // (resp. 0) and the reason in "err"
+   bool save(const string& file, string& err) const;
+   static TaskMgr* load(const string& file, string& err);
+
 private:
-   MinHeap<TaskNode>   _taskHeap;
-   HashSet<TaskNode>   _taskHash;
+   vector<TaskNode>        _tasks;       // live and free task nodes
+   vector<uint32_t>        _freeTasks;   // indices of the free ones
+   TaskQueueType           _queueType;
+   unique_ptr<TaskQueue>   _taskHeap;
+   MyArena                 _arena;       // hash buckets; before _taskHash
+   TaskHash                _taskHash;
+   bool                    _silent;
+
+   // not copyable: the policies of _taskHeap and _taskHash point to
+   // _tasks, and the hash to _arena
+   TaskMgr(const TaskMgr&);
+   TaskMgr& operator = (const TaskMgr&);
+
+   // print the per-node lines
+   bool verbose() const;
+   uint32_t newTask(const TaskNode& n);
+   void freeTask(uint32_t i) { _freeTasks.push_back(i); }
 };
 
 #endif // TASK_MGR
@@ -0,0 +1,58 @@
+/****************************************************************************
+  FileName     [ taskName.cpp ]
+  PackageName  [ task ]
+  Synopsis     [ Define member functions of TaskName ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <string>
+#include <unordered_set>
+#include <mutex>
+#include "taskName.h"
+#include "myHash.h"
+
+using namespace std;
+
+void
+TaskName::set(const char* s, size_t n)
+{
+   memset(_buf, 0, TASK_NAME_SIZE);
+   if (n <= TASK_NAME_INPLACE) {
+      memcpy(_buf, s, n);
+      _buf[TASK_NAME_INPLACE] = char(n);
+   }
+   else {
+      const string* p = intern(s, n);
+      memcpy(_buf, &p, sizeof(p));
+      _buf[TASK_NAME_INPLACE] = char(TASK_NAME_POOLED);
+   }
+}
+
+size_t
+TaskName::hash() const
+{
+   return hashBytes(data(), size());
+}
+
+size_t
+TaskName::legacyHash() const
+{
+   const char* name = data();
+   size_t k = 0, n = (size() <= 5)? size(): 5;
+   for (size_t i = 0; i < n; ++i)
+      k ^= (name[i] << (i*6));
+   return k;
+}
+
+// Pooled names are never released; there are few of them and a
+// TaskName may be copied anywhere. Names may be made by many threads
+// (see ShardedTaskMgr), hence the lock.
+const string*
+TaskName::intern(const char* s, size_t n)
+{
+   static unordered_set<string> pool;
+   static mutex lock;
+   lock_guard<mutex> guard(lock);
+   return &*pool.insert(string(s, n)).first;
+}
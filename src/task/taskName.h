@@ -0,0 +1,73 @@
+/****************************************************************************
+  FileName     [ taskName.h ]
+  PackageName  [ task ]
+  Synopsis     [ Define the compact name type of task nodes ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef TASK_NAME_H
+#define TASK_NAME_H
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <stdint.h>
+
+using namespace std;
+
+//----------------------------------------------------------------------
+//    TaskName: a 16-byte, in-place name
+//----------------------------------------------------------------------
+// Names of up to 15 characters are stored in place, padded with '\0',
+// and the last byte keeps the length.
+// Longer names are interned in a global pool; the first 8 bytes then
+// point to the pooled string, and the last byte is TASK_NAME_POOLED.
+// Since a pooled string is never duplicated, two names are equal iff
+// their 16 bytes are equal, i.e. two 8-byte compares.
+//
+class TaskName
+{
+#define TASK_NAME_SIZE     16
+#define TASK_NAME_INPLACE  (TASK_NAME_SIZE - 1)
+#define TASK_NAME_POOLED   0xff
+
+public:
+   TaskName() { memset(_buf, 0, TASK_NAME_SIZE); }
+   TaskName(const char* s, size_t n) { set(s, n); }
+   TaskName(const string& s) { set(s.data(), s.size()); }
+
+   bool pooled() const { return (unsigned char)_buf[TASK_NAME_INPLACE]
+                                == TASK_NAME_POOLED; }
+   size_t size() const {
+      return pooled()? pooledStr()->size(): _buf[TASK_NAME_INPLACE]; }
+   const char* data() const {
+      return pooled()? pooledStr()->data(): _buf; }
+   string str() const { return string(data(), size()); }
+
+   // hashBytes() of the whole name
+   size_t hash() const;
+   // the hash of the reference program: only the first 5 characters count
+   size_t legacyHash() const;
+
+   bool operator == (const TaskName& n) const {
+      return word(0) == n.word(0) && word(1) == n.word(1); }
+   bool operator != (const TaskName& n) const { return !(*this == n); }
+
+   friend ostream& operator << (ostream& os, const TaskName& n) {
+      return os.write(n.data(), n.size()); }
+
+private:
+   alignas(8) char   _buf[TASK_NAME_SIZE];
+
+   void set(const char* s, size_t n);
+   uint64_t word(size_t i) const {
+      uint64_t w; memcpy(&w, _buf + 8 * i, 8); return w; }
+   const string* pooledStr() const {
+      const string* p; memcpy(&p, _buf, sizeof(p)); return p; }
+
+   // return the only copy of s[0, n) in the pool
+   static const string* intern(const char* s, size_t n);
+};
+
+#endif // TASK_NAME_H
@@ -0,0 +1,49 @@
+/****************************************************************************
+  FileName     [ taskOut.cpp ]
+  PackageName  [ task ]
+  Synopsis     [ Define the output mode of task commands ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include "taskOut.h"
+
+using namespace std;
+
+TaskOut taskOut;
+
+void
+TaskOutBuf::flushOut()
+{
+  if( pptr() == pbase() )
+    return;
+  cout.write( pbase(), pptr() - pbase() );
+  cout.flush();
+  setp( pbase(), epptr() );
+}
+
+TaskOutBuf::int_type
+TaskOutBuf::overflow( int_type c )
+{
+  flushOut();
+  if( !traits_type::eq_int_type( c, traits_type::eof() ) )
+  {
+    *pptr() = traits_type::to_char_type( c );
+    pbump( 1 );
+  }
+  return traits_type::not_eof( c );
+}
+
+void
+TaskOut::endSummary()
+{
+  if( _mode == TASK_OUT_SUMMARY )
+  {
+    timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    double t = ( now.tv_sec - _start.tv_sec )
+             + ( now.tv_nsec - _start.tv_nsec ) * 1e-9;
+    os() << " (" << t << " seconds)";
+  }
+  os() << endl;
+}
@@ -0,0 +1,96 @@
+/****************************************************************************
+  FileName     [ taskOut.h ]
+  PackageName  [ task ]
+  Synopsis     [ Define the output mode of task commands ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef TASK_OUT_H
+#define TASK_OUT_H
+
+#include <iostream>
+#include <streambuf>
+#include <vector>
+#include <time.h>
+#include "util.h"
+
+using namespace std;
+
+//----------------------------------------------------------------------
+//    TaskOut: where the task commands write to
+//----------------------------------------------------------------------
+// Set by TASKOutput. Error messages always go to cerr right away.
+//
+enum TaskOutMode
+{
+   TASK_OUT_NORMAL,     // every line, each flushed at once (endl)
+   TASK_OUT_BUFFERED,   // every line, flushed once per command
+   TASK_OUT_SUMMARY,    // no per-node lines; counts with timing
+   TASK_OUT_QUIET       // nothing but errors
+};
+
+// A large buffer in front of cout whose sync() (e.g. from endl) does
+// nothing; it is only written out when full or by flushOut().
+class TaskOutBuf : public streambuf
+{
+#define TASK_OUT_BUF_SIZE   (1 << 20)
+
+public:
+   TaskOutBuf() : _buf(TASK_OUT_BUF_SIZE) {
+      setp(&_buf[0], &_buf[0] + _buf.size()); }
+
+   void flushOut();
+
+protected:
+   int_type overflow(int_type c);
+   int sync() { return 0; }
+
+private:
+   vector<char>   _buf;
+};
+
+class TaskOut
+{
+public:
+   TaskOut() : _os(&_buf), _mode(TASK_OUT_NORMAL) { begin(); }
+   ~TaskOut() { flush(); }
+
+   TaskOutMode mode() const { return _mode; }
+   void setMode(TaskOutMode m) { flush(); _mode = m; }
+
+   // the per-node lines, e.g. "Task node inserted: ..."
+   bool verbose() const { return _mode <= TASK_OUT_BUFFERED; }
+   // anything else but errors
+   bool enabled() const { return _mode != TASK_OUT_QUIET; }
+
+   ostream& os() { return (_mode == TASK_OUT_NORMAL)? cout: _os; }
+   // end a summary line; in TASK_OUT_SUMMARY the time since begin()
+   // is appended
+   void endSummary();
+
+   // called at the start and the end of each task command
+   void begin() { clock_gettime(CLOCK_MONOTONIC, &_start); }
+   void flush() { _buf.flushOut(); }
+
+private:
+   TaskOutBuf    _buf;
+   ostream       _os;
+   TaskOutMode   _mode;
+   timespec      _start;
+};
+
+extern TaskOut taskOut;
+
+// begin() and flush() of taskOut around a task command, which is also
+// timed in myProfile under its name
+struct TaskOutScope
+{
+   TaskOutScope(const char* name) : _timer(name, myProfile) {
+      taskOut.begin(); }
+   ~TaskOutScope() { taskOut.flush(); }
+
+   MyTimer   _timer;
+};
+
+#endif // TASK_OUT_H
@@ -0,0 +1,156 @@
+/****************************************************************************
+  FileName     [ taskShard.cpp ]
+  PackageName  [ task ]
+  Synopsis     [ Define the sharded, thread-safe task manager ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <new>
+#include "taskShard.h"
+
+using namespace std;
+
+ShardedTaskMgr::ShardedTaskMgr(size_t nShards, size_t nMachines)
+: _top(ShardMin(&_shards), nShards), _nodes(nMachines)
+{
+  size_t perShard = nMachines / nShards + 1;
+  for( size_t i = 0; i < nShards; ++i )
+  {
+    Shard* s = CacheAlignedAlloc<Shard>().allocate( 1 );
+    _shards.push_back( new (s) Shard( perShard ) );
+  }
+  for( size_t i = 0; i < nShards; ++i )
+    _top.insert( i );
+}
+
+ShardedTaskMgr::~ShardedTaskMgr()
+{
+  for( size_t i = 0; i < _shards.size(); ++i )
+  {
+    _shards[i]->~Shard();
+    CacheAlignedAlloc<Shard>().deallocate( _shards[i], 1 );
+  }
+}
+
+size_t
+ShardedTaskMgr::size() const
+{
+  size_t n = 0;
+  for( size_t i = 0; i < _shards.size(); ++i )
+  {
+    lock_guard<mutex> guard( _shards[i]->_lock );
+    n += _shards[i]->_mgr.size();
+  }
+  return n;
+}
+
+// the high half of the name hash; TaskHash uses it modulo a prime, so
+// the tasks of a shard still spread over all its buckets.
+size_t
+ShardedTaskMgr::shardOf( const TaskName& name ) const
+{
+  uint64_t h = name.hash();
+  return ( ( h >> 32 ) * _shards.size() ) >> 32;
+}
+
+bool
+ShardedTaskMgr::publishMin( Shard& s )
+{
+  size_t m = s._mgr.empty()? SIZE_MAX: s._mgr.min().getLoad();
+  if( m == s._min.load( memory_order_relaxed ) )
+    return false;
+  s._min.store( m, memory_order_relaxed );
+  return true;
+}
+
+void
+ShardedTaskMgr::updateTop( size_t s )
+{
+  lock_guard<mutex> guard( _topLock );
+  // picks up the latest _min of s, whoever published it
+  _top.updateKey( _top.slot( s ) );
+}
+
+bool
+ShardedTaskMgr::add( const string& name, size_t load )
+{
+  size_t i = shardOf( TaskName( name ) );
+  Shard& s = *_shards[i];
+  bool changed;
+  {
+    lock_guard<mutex> guard( s._lock );
+    if( !s._mgr.add( name, load ) )
+      return false;
+    _nodes.insert( TaskNode( name, load ) );
+    changed = publishMin( s );
+  }
+  if( changed )
+    updateTop( i );
+  return true;
+}
+
+bool
+ShardedTaskMgr::remove( const string& name )
+{
+  size_t i = shardOf( TaskName( name ) );
+  Shard& s = *_shards[i];
+  bool changed;
+  {
+    lock_guard<mutex> guard( s._lock );
+    if( !s._mgr.remove( name ) )
+      return false;
+    _nodes.remove( TaskNode( name, 0 ) );
+    changed = publishMin( s );
+  }
+  if( changed )
+    updateTop( i );
+  return true;
+}
+
+size_t
+ShardedTaskMgr::lockTop( unique_lock<mutex>& guard ) const
+{
+  while( true )
+  {
+    size_t i = _top.min();
+    guard = unique_lock<mutex>( _shards[i]->_lock );
+    if( !_shards[i]->_mgr.empty() || _top.key( 0 ) == SIZE_MAX )
+      return i;
+    // emptied by a remove() that has not updated _top yet; refresh the
+    // key of i and look again
+    guard.unlock();
+    _top.updateKey( _top.slot( i ) );
+  }
+}
+
+bool
+ShardedTaskMgr::assign( size_t l )
+{
+  lock_guard<mutex> top( _topLock );
+  unique_lock<mutex> guard;
+  size_t i = lockTop( guard );
+  Shard& s = *_shards[i];
+  if( s._mgr.empty() )
+    return false;   // so are all the others
+  TaskNode n = s._mgr.min();
+  s._mgr.assign( l );
+  n += l;
+  _nodes.update( n );
+  publishMin( s );
+  guard.unlock();
+  _top.updateKey( _top.slot( i ) );
+  return true;
+}
+
+bool
+ShardedTaskMgr::min( TaskNode& n ) const
+{
+  lock_guard<mutex> top( _topLock );
+  unique_lock<mutex> guard;
+  const Shard& s = *_shards[lockTop( guard )];
+  if( s._mgr.empty() )
+    return false;
+  n = s._mgr.min();
+  return true;
+}
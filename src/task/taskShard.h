@@ -0,0 +1,103 @@
+/****************************************************************************
+  FileName     [ taskShard.h ]
+  PackageName  [ task ]
+  Synopsis     [ Define the sharded, thread-safe task manager ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef TASK_SHARD_H
+#define TASK_SHARD_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include "taskMgr.h"
+#include "myConcurrentHashSet.h"
+
+using namespace std;
+
+//----------------------------------------------------------------------
+//    ShardedTaskMgr: TaskMgr for many threads
+//----------------------------------------------------------------------
+// The tasks are split by the hash of their names over N shards, each a
+// TaskMgr (hash, heap, arena) of its own behind its own lock, so that
+// add/remove/query of names in different shards run in parallel.
+//
+// The min load of every shard is published in "_min" and kept in a small
+// heap of the shards ("_top") for assign(), which takes the top lock and
+// then the lock of the shard on top. add() and remove() take the top lock
+// only when they changed the min of their shard, and never while holding
+// the shard lock, so there is no lock order to get wrong.
+//
+// Every change of a node is also copied into "_nodes", under the lock of
+// its shard, so query() runs without any lock (see ConcurrentHashSet).
+// The tables "_nodes" outgrows are kept for the readers until reclaim().
+//
+// With concurrent callers assign() goes to a shard whose min was the
+// global min an instant ago; with a single caller it is exact. A shard
+// on top that has just been emptied is not taken for all of them: its
+// key is refreshed and the next one is tried (see lockTop()).
+// No per-node output is printed, whatever the TASKOutput mode.
+// The histograms of -DMY_STATS are not locked; do not gather statistics
+// with more than one thread.
+//
+class ShardedTaskMgr
+{
+public:
+   ShardedTaskMgr(size_t nShards, size_t nMachines);
+   ~ShardedTaskMgr();
+
+   size_t numShards() const { return _shards.size(); }
+   size_t size() const;
+
+   bool add(const string& name, size_t load);
+   bool remove(const string& name);
+   // see TaskMgr::query(); lock-free
+   bool query(TaskNode& n) const { return _nodes.query(n); }
+   bool assign(size_t l);
+   // copy the min task node into n; false if empty
+   bool min(TaskNode& n) const;
+   // free the outgrown tables of _nodes; only at a quiescent point, when
+   // no other thread uses this manager
+   void reclaim() { _nodes.reclaim(); }
+
+private:
+   // allocated cache line aligned (see the constructor), so that the
+   // lock and min of two shards never share a line
+   struct Shard
+   {
+      Shard(size_t nMachines) : _min(SIZE_MAX), _mgr(nMachines) {
+         _mgr.setSilent(true); }
+      mutable mutex    _lock;
+      atomic<size_t>   _min;      // SIZE_MAX if empty
+      TaskMgr          _mgr;
+   };
+   // the key of a shard in _top
+   struct ShardMin
+   {
+      typedef size_t Key;
+      ShardMin(const vector<Shard*>* s = 0) : _shards(s) {}
+      size_t operator () (uint32_t s) const {
+         return (*_shards)[s]->_min.load(memory_order_relaxed); }
+      const vector<Shard*>*   _shards;
+   };
+
+   vector<Shard*>             _shards;
+   mutable mutex              _topLock;
+   // refreshed by min() too, hence mutable
+   mutable KeyMinHeap<ShardMin, 4>   _top;
+   ConcurrentHashSet<TaskNode>   _nodes;
+
+   size_t shardOf(const TaskName& name) const;
+   // re-read the min of shard s; called with the lock of s held.
+   // return true if it changed.
+   static bool publishMin(Shard& s);
+   void updateTop(size_t s);
+   // the shard on top of _top, locked by "guard"; empty only if all the
+   // shards are. Called with the top lock held.
+   size_t lockTop(unique_lock<mutex>& guard) const;
+};
+
+#endif // TASK_SHARD_H
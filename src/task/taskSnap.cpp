@@ -0,0 +1,387 @@
+/****************************************************************************
+  FileName     [ taskSnap.cpp ]
+  PackageName  [ task ]
+  Synopsis     [ Define the binary snapshots of TaskMgr ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "taskMgr.h"
+#include "myHash.h"
+
+using namespace std;
+
+//----------------------------------------------------------------------
+//    The snapshot file
+//----------------------------------------------------------------------
+// A SnapHeader, then, with m entries in _tasks and n tasks of them live,
+//    nodes[m]    _tasks; a pooled name holds the offset of its string in
+//                strs in place of the pointer, and a free entry is zeros
+//    places[n]   places() of the hash (uint64_t)
+//    free[m-n]   _freeTasks (uint32_t)
+//    heap[n]     the tasks in the order of the queue slots (uint32_t)
+//    ids[n]      the tasks of the hash in the order of its iterators
+//                (uint32_t)
+//    strs        the pooled names, each a uint64_t length and the bytes
+// all in the byte order of the host. The 64-bit arrays come first, so
+// every array is aligned in the mapped file. The checksum chains
+// hashBytes() over the rest, one TASK_SNAP_CHUNK at a time, and then over
+// the header (with the checksum as 0).
+//
+// Loading maps the file (mmap) and takes the nodes as they are, only
+// interning the pooled names again. Every task keeps its index, which
+// breaks the ties of TaskHeap, and the free entries are reused in the
+// same order, so the loaded manager goes on exactly as the saved one.
+// The queue gets the tasks in the saved slot order, which is a heap
+// already, so heapify() moves nothing; the hash adopts the saved layout.
+// Nothing is sifted per node; each name is only looked up once, to check
+// that the hash finds it as itself, i.e. no two tasks share a name. A
+// file from a build with another hash (TASK_OPEN_HASH, TASK_LEGACY_HASH)
+// still loads, but its hash is rebuilt by inserting.
+// With -Radix the slots are the same, but ties in min() may break
+// differently after loading.
+//
+namespace
+{
+   struct SnapHeader
+   {
+#define TASK_SNAP_MAGIC     "TASKSNAP"
+#define TASK_SNAP_VERSION   3
+#define TASK_SNAP_CHUNK     (1 << 16)
+// _flags
+#define TASK_SNAP_RADIX     0x1
+#define TASK_SNAP_OPEN      0x2
+#define TASK_SNAP_LEGACY    0x4
+
+      char       _magic[8];
+      uint32_t   _version;
+      uint32_t   _flags;
+      uint64_t   _numTasks;
+      uint64_t   _numEntries;    // of _tasks, free ones included
+      uint64_t   _numBuckets;
+      uint64_t   _strBytes;
+      uint64_t   _checksum;
+      uint64_t   _reserved;
+   };
+
+   struct SnapNode
+   {
+      char       _name[TASK_NAME_SIZE];
+      uint64_t   _load;
+   };
+
+   // the flags of the hash of this build
+   uint32_t
+   hashFlags()
+   {
+     uint32_t f = 0;
+#ifdef TASK_OPEN_HASH
+     f |= TASK_SNAP_OPEN;
+#endif
+#ifdef TASK_LEGACY_HASH
+     f |= TASK_SNAP_LEGACY;
+#endif
+     return f;
+   }
+
+   uint64_t
+   checksum( uint64_t sum, const char* p, size_t n )
+   {
+     for( size_t i = 0; i < n; i += TASK_SNAP_CHUNK )
+       sum = hashBytes( p + i, min( n - i, size_t( TASK_SNAP_CHUNK ) ),
+                        sum );
+     return sum;
+   }
+
+   // "sum" is that of the rest
+   uint64_t
+   headerSum( SnapHeader h, uint64_t sum )
+   {
+     h._checksum = 0;
+     return checksum( sum, (const char*)&h, sizeof( h ) );
+   }
+
+   // the rest of the file, checksummed one chunk at a time
+   class SnapOut
+   {
+   public:
+      SnapOut(ofstream& f, uint64_t sum)
+         : _file(f), _buf(TASK_SNAP_CHUNK), _used(0), _sum(sum) {}
+
+      void write(const void* p, size_t n) {
+         const char* s = (const char*)p;
+         while (n != 0) {
+            size_t k = min(n, _buf.size() - _used);
+            memcpy(&_buf[_used], s, k);
+            _used += k; s += k; n -= k;
+            if (_used == _buf.size()) flush();
+         }
+      }
+      // write out what is left; return the checksum
+      uint64_t finish() { flush(); return _sum; }
+
+   private:
+      ofstream&      _file;
+      vector<char>   _buf;
+      size_t         _used;
+      uint64_t       _sum;
+
+      void flush() {
+         _sum = checksum(_sum, _buf.data(), _used);
+         _file.write(_buf.data(), _used);
+         _used = 0;
+      }
+   };
+
+   // a whole file, mapped read-only
+   class SnapMap
+   {
+   public:
+      SnapMap() : _p(0), _n(0) {}
+      ~SnapMap() { if (_p) munmap(_p, _n); }
+
+      bool open(const string& file) ;
+      const char* data() const { return (const char*)_p; }
+      size_t size() const { return _n; }
+
+   private:
+      void*    _p;
+      size_t   _n;
+   };
+
+   bool
+   SnapMap::open( const string& file )
+   {
+     int fd = ::open( file.c_str(), O_RDONLY );
+     if( fd < 0 )
+       return false;
+     struct stat st;
+     bool ok = ( fstat( fd, &st ) == 0 );
+     if( ok && st.st_size > 0 )
+     {
+       _n = st.st_size;
+       _p = mmap( 0, _n, PROT_READ, MAP_PRIVATE, fd, 0 );
+       if( _p == MAP_FAILED )
+       {
+         _p = 0;
+         ok = false;
+       }
+       else
+         // read once for the checksum, then once to build
+         madvise( _p, _n, MADV_SEQUENTIAL );
+     }
+     close( fd );
+     return ok;
+   }
+}
+
+//----------------------------------------------------------------------
+//    TaskMgr::save() and load()
+//----------------------------------------------------------------------
+bool
+TaskMgr::save( const string& file, string& err ) const
+{
+  static_assert( sizeof( TaskName ) == TASK_NAME_SIZE &&
+                 is_trivially_copyable<TaskName>::value,
+                 "a TaskName is saved as its bytes" );
+  ofstream f( file.c_str(), ios::binary | ios::trunc );
+  if( !f )
+  {
+    err = "cannot open file \"" + file + "\"";
+    return false;
+  }
+  SnapHeader h;
+  memset( &h, 0, sizeof( h ) );
+  memcpy( h._magic, TASK_SNAP_MAGIC, sizeof( h._magic ) );
+  h._version = TASK_SNAP_VERSION;
+  h._flags = hashFlags();
+  if( _queueType == TASK_QUEUE_RADIX )
+    h._flags |= TASK_SNAP_RADIX;
+  h._numTasks = size();
+  h._numEntries = _tasks.size();
+  h._numBuckets = _taskHash.numBuckets();
+  // the real header goes last, once the rest is known
+  f.write( (const char*)&h, sizeof( h ) );
+
+  SnapOut out( f, TASK_SNAP_VERSION );
+  vector<bool> isFree( _tasks.size(), false );
+  for( size_t i = 0; i < _freeTasks.size(); ++i )
+    isFree[_freeTasks[i]] = true;
+  string strs;
+  for( size_t i = 0; i < _tasks.size(); ++i )
+  {
+    const TaskNode& t = _tasks[i];
+    SnapNode s;
+    memset( &s, 0, sizeof( s ) );
+    if( isFree[i] )
+    {
+      out.write( &s, sizeof( s ) );
+      continue;
+    }
+    memcpy( s._name, &t.getName(), TASK_NAME_SIZE );
+    s._load = t.getLoad();
+    if( t.getName().pooled() )
+    {
+      uint64_t off = strs.size(), len = t.getName().size();
+      memcpy( s._name, &off, sizeof( off ) );
+      strs.append( (const char*)&len, sizeof( len ) );
+      strs.append( t.getName().data(), len );
+    }
+    out.write( &s, sizeof( s ) );
+  }
+  vector<uint64_t> places;
+  _taskHash.places( places );
+  out.write( places.data(), places.size() * sizeof( uint64_t ) );
+  out.write( _freeTasks.data(), _freeTasks.size() * sizeof( uint32_t ) );
+  for( size_t i = 0, n = size(); i < n; ++i )
+  {
+    uint32_t t = (*_taskHeap)[i];
+    out.write( &t, sizeof( t ) );
+  }
+  for( TaskHash::iterator it = _taskHash.begin(); it != _taskHash.end();
+       ++it )
+    out.write( &*it, sizeof( uint32_t ) );
+  out.write( strs.data(), strs.size() );
+
+  h._strBytes = strs.size();
+  h._checksum = headerSum( h, out.finish() );
+  f.seekp( 0 );
+  f.write( (const char*)&h, sizeof( h ) );
+  f.close();
+  if( !f )
+  {
+    err = "cannot write to file \"" + file + "\"";
+    return false;
+  }
+  return true;
+}
+
+TaskMgr*
+TaskMgr::load( const string& file, string& err )
+{
+  SnapMap m;
+  if( !m.open( file ) )
+  {
+    err = "cannot open file \"" + file + "\"";
+    return 0;
+  }
+  SnapHeader h;
+  if( m.size() < sizeof( h )
+      || memcmp( m.data(), TASK_SNAP_MAGIC, sizeof( h._magic ) ) != 0 )
+  {
+    err = "\"" + file + "\" is not a task snapshot";
+    return 0;
+  }
+  memcpy( &h, m.data(), sizeof( h ) );
+  if( h._version != TASK_SNAP_VERSION )
+  {
+    err = "\"" + file + "\" is of snapshot version "
+          + to_string( h._version ) + " (expecting "
+          + to_string( TASK_SNAP_VERSION ) + ")";
+    return 0;
+  }
+  // every entry has a node and is either free or in the queue; every
+  // task is also in the hash
+  const size_t perEntry = sizeof( SnapNode ) + sizeof( uint32_t );
+  const size_t perTask = sizeof( uint64_t ) + sizeof( uint32_t );
+  const size_t n = h._numTasks, e = h._numEntries;
+  const size_t rest = m.size() - sizeof( h );
+  err = "\"" + file + "\" is corrupted";
+  if( e > UINT32_MAX || n > e || h._strBytes > rest
+      || e * perEntry + n * perTask != rest - h._strBytes )
+    return 0;
+  if( headerSum( h, checksum( TASK_SNAP_VERSION, m.data() + sizeof( h ),
+                              rest ) ) != h._checksum )
+  {
+    err += " (checksum mismatch)";
+    return 0;
+  }
+  static_assert( sizeof( SnapHeader ) % sizeof( uint64_t ) == 0 &&
+                 sizeof( SnapNode ) % sizeof( uint64_t ) == 0,
+                 "places[] is 64-bit aligned" );
+  const SnapNode* nodes = (const SnapNode*)( m.data() + sizeof( h ) );
+  const uint64_t* places = (const uint64_t*)( nodes + e );
+  const uint32_t* frees = (const uint32_t*)( places + n );
+  const uint32_t* heap = frees + ( e - n );
+  const uint32_t* ids = heap + n;
+  const char* strs = (const char*)( ids + n );
+
+  // the free entries and the queue must cover _tasks exactly once
+  vector<bool> seen( e, false );
+  for( size_t i = 0; i < e; ++i )
+  {
+    uint32_t t = ( i < e - n )? frees[i]: heap[i - ( e - n )];
+    if( t >= e || seen[t] )
+      return 0;
+    seen[t] = true;
+  }
+
+  TaskMgr* mgr = new TaskMgr( 0, ( h._flags & TASK_SNAP_RADIX )?
+                                 TASK_QUEUE_RADIX: TASK_QUEUE_HEAP );
+  mgr->_tasks.reserve( e );
+  for( size_t i = 0; i < e; ++i )
+  {
+    TaskName name;
+    memcpy( &name, nodes[i]._name, TASK_NAME_SIZE );
+    if( name.pooled() )
+    {
+      uint64_t off, len;
+      memcpy( &off, nodes[i]._name, sizeof( off ) );
+      if( off > h._strBytes || h._strBytes - off < sizeof( len ) )
+        break;
+      memcpy( &len, strs + off, sizeof( len ) );
+      if( len > h._strBytes - off - sizeof( len ) )
+        break;
+      name = TaskName( strs + off + sizeof( len ), len );
+    }
+    mgr->_tasks.push_back( TaskNode( name, nodes[i]._load ) );
+  }
+  mgr->_freeTasks.assign( frees, frees + ( e - n ) );
+  // the ids must be the tasks in the queue, each once; "seen" marks the
+  // ones not met yet from here
+  for( size_t i = 0; i < e - n; ++i )
+    seen[frees[i]] = false;
+  bool ok = ( mgr->_tasks.size() == e );
+  for( size_t k = 0; ok && k < n; ++k )
+  {
+    ok = ( ids[k] < e && seen[ids[k]] );
+    if( ok )
+      seen[ids[k]] = false;
+  }
+  if( ok && ( h._flags & ~TASK_SNAP_RADIX ) == hashFlags() )
+    ok = mgr->_taskHash.adopt( h._numBuckets, ids, places, n );
+  else if( ok )
+  {
+    // the places are of another hash function or table
+    mgr->_taskHash.reserve( n );
+    for( size_t k = 0; ok && k < n; ++k )
+      ok = mgr->_taskHash.insert( ids[k] );
+  }
+  // each task must be found by its name as itself; this also rejects
+  // two tasks of one name, and places the names do not hash to
+  ok = ok && mgr->_taskHash.size() == n;
+  for( size_t k = 0; ok && k < n; ++k )
+  {
+    const uint32_t* p = mgr->_taskHash.findKey(
+                          mgr->_tasks[ids[k]].getName() );
+    ok = ( p != nullptr && *p == ids[k] );
+  }
+  if( !ok )
+  {
+    delete mgr;
+    return 0;
+  }
+  mgr->_taskHeap->insertAll( vector<uint32_t>( heap, heap + n ) );
+  err.clear();
+  return mgr;
+}
@@ -1,3 +1,5 @@
-myString.o: myString.cpp
 myGetChar.o: myGetChar.cpp
-util.o: util.cpp rnGen.h myUsage.h
+myStats.o: myStats.cpp myStats.h
+myString.o: myString.cpp
+rnGen.o: rnGen.cpp rnGen.h
+util.o: util.cpp rnGen.h myUsage.h myStats.h
@@ -1,4 +1,4 @@
-util.d: ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h ../../include/myHashSet.h ../../include/myMinHeap.h 
+util.d: ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h ../../include/myHashSet.h ../../include/myMinHeap.h ../../include/myOpenHashSet.h ../../include/myHash.h ../../include/myRadixHeap.h ../../include/myStats.h ../../include/myArena.h ../../include/myConcurrentHashSet.h ../../include/myThreadPool.h 
 ../../include/util.h: util.h
 	@rm -f ../../include/util.h
 	@ln -fs ../src/util/util.h ../../include/util.h
@@ -14,3 +14,24 @@ util.d: ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h ../..
 ../../include/myMinHeap.h: myMinHeap.h
 	@rm -f ../../include/myMinHeap.h
 	@ln -fs ../src/util/myMinHeap.h ../../include/myMinHeap.h
+../../include/myOpenHashSet.h: myOpenHashSet.h
+	@rm -f ../../include/myOpenHashSet.h
+	@ln -fs ../src/util/myOpenHashSet.h ../../include/myOpenHashSet.h
+../../include/myHash.h: myHash.h
+	@rm -f ../../include/myHash.h
+	@ln -fs ../src/util/myHash.h ../../include/myHash.h
+../../include/myRadixHeap.h: myRadixHeap.h
+	@rm -f ../../include/myRadixHeap.h
+	@ln -fs ../src/util/myRadixHeap.h ../../include/myRadixHeap.h
+../../include/myStats.h: myStats.h
+	@rm -f ../../include/myStats.h
+	@ln -fs ../src/util/myStats.h ../../include/myStats.h
+../../include/myArena.h: myArena.h
+	@rm -f ../../include/myArena.h
+	@ln -fs ../src/util/myArena.h ../../include/myArena.h
+../../include/myConcurrentHashSet.h: myConcurrentHashSet.h
+	@rm -f ../../include/myConcurrentHashSet.h
+	@ln -fs ../src/util/myConcurrentHashSet.h ../../include/myConcurrentHashSet.h
+../../include/myThreadPool.h: myThreadPool.h
+	@rm -f ../../include/myThreadPool.h
+	@ln -fs ../src/util/myThreadPool.h ../../include/myThreadPool.h
@@ -0,0 +1,188 @@
+/****************************************************************************
+  FileName     [ myArena.h ]
+  PackageName  [ util ]
+  Synopsis     [ Define MyArena, a pool of small blocks, and its allocator ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef MY_ARENA_H
+#define MY_ARENA_H
+
+#include <new>
+#include <memory>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
+using namespace std;
+
+//---------------------
+// Define MyArena class
+//---------------------
+// Small blocks are carved out of large chunks and rounded up to a power
+// of 2 (size class); a freed block goes to the free list of its class
+// and is handed out again by the next allocation of that class. So once
+// the blocks of a workload have been allocated, it runs without calling
+// malloc at all.
+// Blocks larger than 2^ARENA_MAX_CLASS bytes go to malloc directly, but
+// are still tracked by the arena.
+//
+// release() (and the destructor) frees all the chunks and large blocks at
+// once, whatever is still in use; the owner of the arena may therefore
+// drop its containers without freeing their blocks one by one (see
+// bulkReleased()).
+//
+class MyArena
+{
+#define ARENA_MIN_CLASS    4            // 16 bytes, the alignment
+#define ARENA_MAX_CLASS    16           // 64 KB
+#define ARENA_CHUNK_SIZE   (1 << 20)
+
+public:
+   MyArena() : _chunks(0), _big(0), _cur(0), _end(0) {
+      memset(_free, 0, sizeof(_free)); }
+   ~MyArena() { release(); }
+
+   void* allocate(size_t n);
+   void deallocate(void* p, size_t n);
+   void release();
+
+private:
+   // a chunk or a large block, in front of its memory
+   struct Header
+   {
+      Header*   _prev;
+      Header*   _next;
+   };
+   struct FreeBlock
+   {
+      FreeBlock*   _next;
+   };
+
+   Header*      _chunks;
+   Header*      _big;
+   char*        _cur;       // free part of the current chunk
+   char*        _end;
+   FreeBlock*   _free[ARENA_MAX_CLASS + 1];
+
+   MyArena(const MyArena&);             // not copyable
+   MyArena& operator = (const MyArena&);
+
+   static size_t sizeClass(size_t n) {
+      return (n <= (1 << ARENA_MIN_CLASS))? ARENA_MIN_CLASS:
+             64 - __builtin_clzll(n - 1); }
+   static void* newBlock(Header*& list, size_t n);
+};
+
+inline void*
+MyArena::newBlock( Header*& list, size_t n )
+{
+  Header* h = static_cast<Header*>( malloc( sizeof(Header) + n ) );
+  if( h == 0 )
+    throw bad_alloc();
+  h->_prev = 0;
+  h->_next = list;
+  if( list != 0 )
+    list->_prev = h;
+  list = h;
+  return h + 1;
+}
+
+inline void*
+MyArena::allocate( size_t n )
+{
+  size_t c = sizeClass( n );
+  if( c > ARENA_MAX_CLASS )
+    return newBlock( _big, n );
+  if( _free[c] != 0 )
+  {
+    FreeBlock* b = _free[c];
+    _free[c] = b->_next;
+    return b;
+  }
+  size_t s = size_t(1) << c;
+  if( size_t( _end - _cur ) < s )
+  {
+    // the rest of the current chunk is dropped
+    _cur = static_cast<char*>( newBlock( _chunks, ARENA_CHUNK_SIZE ) );
+    _end = _cur + ARENA_CHUNK_SIZE;
+  }
+  void* p = _cur;
+  _cur += s;
+  return p;
+}
+
+inline void
+MyArena::deallocate( void* p, size_t n )
+{
+  size_t c = sizeClass( n );
+  if( c > ARENA_MAX_CLASS )
+  {
+    Header* h = static_cast<Header*>( p ) - 1;
+    if( h->_prev != 0 ) h->_prev->_next = h->_next;
+    else _big = h->_next;
+    if( h->_next != 0 ) h->_next->_prev = h->_prev;
+    free( h );
+    return;
+  }
+  FreeBlock* b = static_cast<FreeBlock*>( p );
+  b->_next = _free[c];
+  _free[c] = b;
+}
+
+inline void
+MyArena::release()
+{
+  Header* lists[] = { _chunks, _big };
+  for( size_t i = 0; i < 2; ++i )
+    while( lists[i] != 0 )
+    {
+      Header* h = lists[i];
+      lists[i] = h->_next;
+      free( h );
+    }
+  _chunks = _big = 0;
+  _cur = _end = 0;
+  memset( _free, 0, sizeof(_free) );
+}
+
+//------------------------
+// Define ArenaAlloc class
+//------------------------
+// A standard allocator drawing from a MyArena; with no arena it falls
+// back to the global operator new.
+//
+template <class T>
+struct ArenaAlloc
+{
+   typedef T value_type;
+
+   ArenaAlloc(MyArena* a = 0) : _arena(a) {}
+   template <class U> ArenaAlloc(const ArenaAlloc<U>& a) : _arena(a._arena) {}
+
+   T* allocate(size_t n) {
+      return static_cast<T*>(_arena? _arena->allocate(n * sizeof(T)):
+                                     ::operator new(n * sizeof(T))); }
+   void deallocate(T* p, size_t n) {
+      if (_arena) _arena->deallocate(p, n * sizeof(T));
+      else ::operator delete(p); }
+
+   MyArena*   _arena;
+};
+
+template <class T, class U>
+bool operator == (const ArenaAlloc<T>& a, const ArenaAlloc<U>& b)
+{ return a._arena == b._arena; }
+template <class T, class U>
+bool operator != (const ArenaAlloc<T>& a, const ArenaAlloc<U>& b)
+{ return a._arena != b._arena; }
+
+// true if the memory from "a" is freed all at once by its owner, so that
+// a container going away need not give back its blocks one by one.
+template <class Alloc>
+bool bulkReleased(const Alloc&) { return false; }
+template <class T>
+bool bulkReleased(const ArenaAlloc<T>& a) { return a._arena != 0; }
+
+#endif // MY_ARENA_H
@@ -0,0 +1,431 @@
+/****************************************************************************
+  FileName     [ myConcurrentHashSet.h ]
+  PackageName  [ util ]
+  Synopsis     [ Define ConcurrentHashSet ADT (lock-free readers) ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef MY_CONCURRENT_HASH_SET_H
+#define MY_CONCURRENT_HASH_SET_H
+
+#include <new>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <cstring>
+#include <type_traits>
+#include <stdint.h>
+#include "util.h"
+#include "myHash.h"
+#include "myMinHeap.h"      // CacheAlignedAlloc
+#include "myOpenHashSet.h"   // RobinHood
+
+using namespace std;
+
+//-------------------------------
+// Define ConcurrentHashSet class
+//-------------------------------
+// A hash for many threads, made for lookups that far outnumber updates.
+// Same semantics of check/query/update/insert/remove as HashSet; there
+// is no iterator.
+//
+// The data are split by hash over CONC_HASH_STRIPES stripes, each an
+// open addressing table (Robin Hood, as in OpenHashSet) with
+//    - a mutex taken by the writers, so writers on different stripes run
+//      in parallel;
+//    - a sequence number ("seqlock"), odd while a writer changes the
+//      table. Readers take no lock: they probe, then retry if the number
+//      was odd or has changed meanwhile.
+// A table that grows is replaced, not changed, and the old one is kept
+// ("retired") until reclaim() or the destructor, so a reader never
+// touches freed memory. The retired tables of a stripe add up to less
+// than its current one, but they stay until the owner calls reclaim()
+// at a point where no other thread uses the hash.
+//
+// Readers may copy a slot that a writer is changing; such a torn copy is
+// thrown away by the sequence check, but it is passed to "Equal" first.
+// Hence "Data" must be trivially copyable, and "Equal" must not follow
+// pointers in it (e.g. comparing names by their bytes is fine).
+//
+template <class Data, class Hasher = DataHash<Data>,
+          class Equal = DataEqual<Data> >
+class ConcurrentHashSet
+{
+#define CONC_HASH_STRIPES    64
+#define CONC_HASH_MAX_DIST   255
+#define CONC_HASH_MAX_LOAD   0.75
+
+   static_assert(is_trivially_copyable<Data>::value,
+                 "ConcurrentHashSet: Data must be trivially copyable");
+
+public:
+   ConcurrentHashSet(size_t b = 0, const Hasher& h = Hasher(),
+                     const Equal& e = Equal()) ;
+   ~ConcurrentHashSet() ;
+
+   // exact only when no writer is running
+   size_t size() const ;
+   bool empty() const { return size() == 0; }
+
+   // same semantics as the HashSet counterparts; any thread may call any
+   // of them at any time
+   bool check(const Data& d) const { Data c(d); return query(c); }
+   bool query(Data& d) const ;
+   bool update(const Data& d) ;
+   bool insert(const Data& d) ;
+   bool remove(const Data& d) ;
+
+   // free the retired tables; no other thread may be using the hash
+   void reclaim() ;
+
+private:
+   struct Table
+   {
+      size_t           _numSlots;
+      Data*            _slots;
+      unsigned char*   _dist;       // as in OpenHashSet; 0 ==> empty
+      Table*           _retired;    // the table this one replaced
+   };
+   // allocated cache line aligned, one by one
+   struct Stripe
+   {
+      atomic<unsigned>   _seq;
+      mutex              _lock;
+      atomic<Table*>     _table;
+      atomic<size_t>     _numData;   // changed under _lock
+   };
+
+   Hasher                  _hasher;
+   Equal                   _equal;
+   vector<Stripe*>         _stripes;
+
+   ConcurrentHashSet(const ConcurrentHashSet&);   // not copyable
+   ConcurrentHashSet& operator = (const ConcurrentHashSet&);
+
+   Stripe& stripe(size_t h) const { return *_stripes[h % CONC_HASH_STRIPES]; }
+   static size_t home(const Table* t, size_t h) {
+      return (h / CONC_HASH_STRIPES) % t->_numSlots; }
+
+   // All the slot and distance accesses that may race with a reader are
+   // relaxed atomics, a word at a time.
+   static void copyData(Data* to, const Data* from) ;
+   // a table, as seen by RobinHood
+   struct Slots
+   {
+      size_t           _n;
+      Data*            _slots;
+      unsigned char*   _dist;
+
+      size_t size() const { return _n; }
+      unsigned char dist(size_t i) const {
+         return __atomic_load_n(_dist + i, __ATOMIC_RELAXED); }
+      void setDist(size_t i, unsigned char d) const {
+         __atomic_store_n(_dist + i, d, __ATOMIC_RELAXED); }
+      void swap(size_t i, Data& d) const {
+         Data tmp(d); copyData(&d, _slots + i); copyData(_slots + i, &tmp); }
+      void put(size_t i, Data& d) const { copyData(_slots + i, &d); }
+      void move(size_t to, size_t from) const {
+         copyData(_slots + to, _slots + from); }
+      void clear(size_t) const {}
+   };
+   static Slots slots(const Table* t) {
+      Slots s = { t->_numSlots, t->_slots, t->_dist }; return s; }
+
+   static void beginWrite(Stripe& s) ;
+   static void endWrite(Stripe& s) ;
+
+   // writers only, with the lock of the stripe held;
+   // return t->_numSlots if d is not in t
+   size_t findSlot(const Table* t, size_t h, const Data& d) const ;
+   // put d into t; if the cluster gets too long, return false, and d is
+   // then the datum (maybe another one) left out of t
+   static bool place(Table* t, size_t h, Data& d) ;
+   static Table* newTable(size_t b) ;
+   static void freeTable(Table* t) ;
+   // put d, which is not in the hash, into stripe s
+   void add(Stripe& s, size_t h, const Data& d) ;
+   // replace the table of s by a larger one holding its data and "extra"
+   void grow(Stripe& s, const Data& extra) ;
+};
+
+template <typename T, typename H, typename E>
+ConcurrentHashSet<T, H, E>::ConcurrentHashSet( size_t b, const H& h,
+                                               const E& e )
+: _hasher( h ), _equal( e )
+{
+  size_t perStripe = getHashSize( b / CONC_HASH_STRIPES );
+  for( size_t i = 0; i < CONC_HASH_STRIPES; ++i )
+  {
+    Stripe* s = CacheAlignedAlloc<Stripe>().allocate( 1 );
+    new (s) Stripe();
+    s->_seq.store( 0, memory_order_relaxed );
+    s->_table.store( newTable( perStripe ), memory_order_relaxed );
+    s->_numData.store( 0, memory_order_relaxed );
+    _stripes.push_back( s );
+  }
+}
+
+template <typename T, typename H, typename E>
+ConcurrentHashSet<T, H, E>::~ConcurrentHashSet()
+{
+  reclaim();
+  for( size_t i = 0; i < _stripes.size(); ++i )
+  {
+    freeTable( _stripes[i]->_table.load( memory_order_relaxed ) );
+    _stripes[i]->~Stripe();
+    CacheAlignedAlloc<Stripe>().deallocate( _stripes[i], 1 );
+  }
+}
+
+template <typename T, typename H, typename E>
+size_t
+ConcurrentHashSet<T, H, E>::size() const
+{
+  size_t n = 0;
+  for( size_t i = 0; i < _stripes.size(); ++i )
+    n += _stripes[i]->_numData.load( memory_order_relaxed );
+  return n;
+}
+
+template <typename T, typename H, typename E>
+void
+ConcurrentHashSet<T, H, E>::reclaim()
+{
+  for( size_t i = 0; i < _stripes.size(); ++i )
+  {
+    Table* t = _stripes[i]->_table.load( memory_order_relaxed );
+    while( t->_retired != nullptr )
+    {
+      Table* r = t->_retired;
+      t->_retired = r->_retired;
+      freeTable( r );
+    }
+  }
+}
+
+template <typename T, typename H, typename E>
+void
+ConcurrentHashSet<T, H, E>::copyData( T* to, const T* from )
+{
+  if( sizeof(T) % 8 == 0 && alignof(T) >= 8 )
+  {
+    uint64_t* d = reinterpret_cast<uint64_t*>( to );
+    const uint64_t* s = reinterpret_cast<const uint64_t*>( from );
+    for( size_t i = 0; i < sizeof(T) / 8; ++i )
+      __atomic_store_n( d + i, __atomic_load_n( s + i, __ATOMIC_RELAXED ),
+                        __ATOMIC_RELAXED );
+  }
+  else
+  {
+    unsigned char* d = reinterpret_cast<unsigned char*>( to );
+    const unsigned char* s = reinterpret_cast<const unsigned char*>( from );
+    for( size_t i = 0; i < sizeof(T); ++i )
+      __atomic_store_n( d + i, __atomic_load_n( s + i, __ATOMIC_RELAXED ),
+                        __ATOMIC_RELAXED );
+  }
+}
+
+template <typename T, typename H, typename E>
+void
+ConcurrentHashSet<T, H, E>::beginWrite( Stripe& s )
+{
+  s._seq.store( s._seq.load( memory_order_relaxed ) + 1,
+                memory_order_relaxed );
+  // the odd number is seen before any change of the table
+  atomic_thread_fence( memory_order_release );
+}
+
+template <typename T, typename H, typename E>
+void
+ConcurrentHashSet<T, H, E>::endWrite( Stripe& s )
+{
+  s._seq.store( s._seq.load( memory_order_relaxed ) + 1,
+                memory_order_release );
+}
+
+template <typename T, typename H, typename E>
+bool
+ConcurrentHashSet<T, H, E>::query( T& other ) const
+{
+  size_t h = _hasher( other );
+  const Stripe& s = stripe( h );
+  typename aligned_storage<sizeof(T), alignof(T)>::type buf;
+  T* cur = reinterpret_cast<T*>( &buf );
+  for( ;; )
+  {
+    unsigned seq = s._seq.load( memory_order_acquire );
+    if( seq & 1 )
+    {
+      // a writer is in; it may have been preempted, so do not just spin
+      this_thread::yield();
+      continue;
+    }
+    const Table* t = s._table.load( memory_order_acquire );
+    // the distance is bounded, so even a torn table cannot keep us here
+    unsigned probes;
+    bool found = RobinHood::find( slots( t ), home( t, h ),
+                                  [&]( size_t i ) {
+                                    copyData( cur, t->_slots + i );
+                                    return _equal( *cur, other ); },
+                                  probes ) != t->_numSlots;
+    atomic_thread_fence( memory_order_acquire );
+    if( s._seq.load( memory_order_relaxed ) != seq )
+      continue;
+    if( found )
+      other = *cur;
+    return found;
+  }
+}
+
+template <typename T, typename H, typename E>
+size_t
+ConcurrentHashSet<T, H, E>::findSlot( const Table* t, size_t h,
+                                      const T& other ) const
+{
+  unsigned probes;
+  return RobinHood::find( slots( t ), home( t, h ),
+                          [&]( size_t i ) {
+                            return _equal( t->_slots[i], other ); },
+                          probes );
+}
+
+template <typename T, typename H, typename E>
+bool
+ConcurrentHashSet<T, H, E>::update( const T& other )
+{
+  size_t h = _hasher( other );
+  Stripe& s = stripe( h );
+  lock_guard<mutex> guard( s._lock );
+  Table* t = s._table.load( memory_order_relaxed );
+  size_t i = findSlot( t, h, other );
+  if( i == t->_numSlots )
+  {
+    add( s, h, other );
+    return false;
+  }
+  beginWrite( s );
+  copyData( t->_slots + i, &other );
+  endWrite( s );
+  return true;
+}
+
+template <typename T, typename H, typename E>
+bool
+ConcurrentHashSet<T, H, E>::insert( const T& other )
+{
+  size_t h = _hasher( other );
+  Stripe& s = stripe( h );
+  lock_guard<mutex> guard( s._lock );
+  Table* t = s._table.load( memory_order_relaxed );
+  if( findSlot( t, h, other ) != t->_numSlots )
+    return false;
+  add( s, h, other );
+  return true;
+}
+
+template <typename T, typename H, typename E>
+void
+ConcurrentHashSet<T, H, E>::add( Stripe& s, size_t h, const T& other )
+{
+  Table* t = s._table.load( memory_order_relaxed );
+  size_t n = s._numData.load( memory_order_relaxed );
+  if( n + 1 > t->_numSlots * CONC_HASH_MAX_LOAD )
+  {
+    grow( s, other );
+    return;
+  }
+  T cur( other );
+  beginWrite( s );
+  if( place( t, h, cur ) )
+    s._numData.store( n + 1, memory_order_relaxed );
+  else
+    // t holds all but "cur"; the readers wait until it is back
+    grow( s, cur );
+  endWrite( s );
+}
+
+template <typename T, typename H, typename E>
+bool
+ConcurrentHashSet<T, H, E>::remove( const T& other )
+{
+  size_t h = _hasher( other );
+  Stripe& s = stripe( h );
+  lock_guard<mutex> guard( s._lock );
+  Table* t = s._table.load( memory_order_relaxed );
+  size_t i = findSlot( t, h, other );
+  if( i == t->_numSlots )
+    return false;
+  beginWrite( s );
+  RobinHood::remove( slots( t ), i );
+  s._numData.store( s._numData.load( memory_order_relaxed ) - 1,
+                    memory_order_relaxed );
+  endWrite( s );
+  return true;
+}
+
+template <typename T, typename H, typename E>
+bool
+ConcurrentHashSet<T, H, E>::place( Table* t, size_t h, T& cur )
+{
+  return RobinHood::place( slots( t ), home( t, h ), cur,
+                           CONC_HASH_MAX_DIST );
+}
+
+template <typename T, typename H, typename E>
+typename ConcurrentHashSet<T, H, E>::Table*
+ConcurrentHashSet<T, H, E>::newTable( size_t b )
+{
+  Table* t = new Table;
+  t->_numSlots = b;
+  t->_slots = static_cast<T*>( ::operator new( b * sizeof(T) ) );
+  t->_dist = new unsigned char[b];
+  memset( t->_dist, 0, b );
+  t->_retired = nullptr;
+  return t;
+}
+
+template <typename T, typename H, typename E>
+void
+ConcurrentHashSet<T, H, E>::freeTable( Table* t )
+{
+  ::operator delete( t->_slots );
+  delete [] t->_dist;
+  delete t;
+}
+
+// The new table is built aside and published at once; the readers on
+// the old one still see all its data.
+template <typename T, typename H, typename E>
+void
+ConcurrentHashSet<T, H, E>::grow( Stripe& s, const T& extra )
+{
+  Table* old = s._table.load( memory_order_relaxed );
+  size_t b = old->_numSlots, n = s._numData.load( memory_order_relaxed );
+  Table* t = nullptr;
+  for( bool done = false; !done; )
+  {
+    do b = getNextHashSize( b ); while( n + 1 > b * CONC_HASH_MAX_LOAD );
+    if( t != nullptr )
+      freeTable( t );
+    t = newTable( b );
+    done = true;
+    for( size_t i = 0; done && i < old->_numSlots; ++i )
+      if( old->_dist[i] )
+      {
+        T cur( old->_slots[i] );
+        done = place( t, _hasher( cur ), cur );
+      }
+    if( done )
+    {
+      T cur( extra );
+      done = place( t, _hasher( cur ), cur );
+    }
+  }
+  t->_retired = old;
+  s._table.store( t, memory_order_release );
+  s._numData.store( n + 1, memory_order_relaxed );
+}
+
+#endif // MY_CONCURRENT_HASH_SET_H
@@ -0,0 +1,90 @@
+/****************************************************************************
+  FileName     [ myHash.h ]
+  PackageName  [ util ]
+  Synopsis     [ Hash functions and the default hasher of the hash ADTs ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef MY_HASH_H
+#define MY_HASH_H
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+//-------------------------
+// Default hash policies
+//-------------------------
+// HashSet and OpenHashSet call their "Hasher" to get the hash key of a
+// Data. The default one asks the Data itself, i.e. Data::operator ().
+// Any class with "size_t operator () (const Data&) const" can be used
+// instead.
+//
+template <class Data>
+struct DataHash
+{
+   size_t operator () (const Data& d) const { return d(); }
+};
+
+// Likewise, the default "Equal" policy is Data::operator ==.
+template <class Data>
+struct DataEqual
+{
+   bool operator () (const Data& a, const Data& b) const { return a == b; }
+};
+
+//----------------------------------------------------------------------
+//    hashBytes(): hash of a byte string
+//----------------------------------------------------------------------
+// A wyhash-style hash: the bytes are read as (at most) 8-byte words,
+// and each pair of words is mixed by one 64x64 -> 128-bit multiply.
+// Every byte of the string affects every bit of the result.
+// Names up to 16 bytes, which covers all the task names in practice,
+// take four loads and two multiplies.
+//
+namespace hash_detail
+{
+   static const uint64_t S0 = 0xa0761d6478bd642full;
+   static const uint64_t S1 = 0xe7037ed1a0b428dbull;
+
+   inline uint64_t mix(uint64_t a, uint64_t b) {
+      __uint128_t r = (__uint128_t)a * b;
+      return uint64_t(r) ^ uint64_t(r >> 64);
+   }
+   inline uint64_t read8(const char* p) {
+      uint64_t v; memcpy(&v, p, 8); return v; }
+   inline uint64_t read4(const char* p) {
+      uint32_t v; memcpy(&v, p, 4); return v; }
+   // 1 to 3 bytes
+   inline uint64_t read3(const char* p, size_t n) {
+      return (uint64_t((unsigned char)p[0]) << 16)
+           | (uint64_t((unsigned char)p[n >> 1]) << 8)
+           | uint64_t((unsigned char)p[n - 1]);
+   }
+}
+
+inline size_t
+hashBytes(const char* p, size_t n, uint64_t seed = 0)
+{
+   using namespace hash_detail;
+   seed ^= mix(seed ^ S0, S1);
+   uint64_t a = 0, b = 0;
+   if (n <= 16) {
+      if (n >= 4) {
+         size_t off = (n >> 3) << 2;
+         a = (read4(p) << 32) | read4(p + off);
+         b = (read4(p + n - 4) << 32) | read4(p + n - 4 - off);
+      }
+      else if (n > 0) a = read3(p, n);
+   }
+   else {
+      size_t i = n;
+      for (; i > 16; i -= 16, p += 16)
+         seed = mix(read8(p) ^ S1, read8(p + 8) ^ seed);
+      a = read8(p + i - 16); b = read8(p + i - 8);
+   }
+   return mix(S1 ^ n, mix(a ^ S1, b ^ seed));
+}
+
+#endif // MY_HASH_H
@@ -10,7 +10,14 @@
 #define MY_HASH_SET_H
 
 #include <vector>
+#include <cassert>
 #include <algorithm>
+#include <memory>
+#include <type_traits>
+#include "util.h"
+#include "myHash.h"
+#include "myStats.h"
+#include "myArena.h"
 
 using namespace std;
 
@@ -23,17 +30,55 @@ using namespace std;
 // "operator ()" is to generate the hash key (size_t)
 // that will be % by _numBuckets to get the bucket number.
 // ==> See "bucketNum()"
+// A different hash function can be plugged in as "Hasher", and a
+// different equivalence as "Equal" (see myHash.h); then "Data" does not
+// need the operators. With such policies, findKey() and removeKey() look
+// up by any key type the policies accept, e.g. a name when "Data" is a
+// handle to a record holding that name.
 //
 // "operator ==" is to check whether there has already been
 // an equivalent "Data" object in the HashSet.
 // Note that HashSet does not allow equivalent nodes to be inserted
 //
-template <class Data>
+// The number of buckets grows (see getNextHashSize()) whenever the load
+// factor, i.e. size() / numBuckets(), exceeds "maxLoadFactor()".
+// In the incremental mode the old buckets are kept after growing and are
+// migrated a few at a time by every insert/update/remove, so that no
+// single operation pays for the whole rehash. Until the migration is
+// done, a data lives either in its old bucket or in its new one.
+//
+// A bitmap of the non-empty buckets is kept along with the buckets, so
+// that begin(), clear() and the iterators skip empty buckets 64 at a time.
+//
+// The buckets, and the array of them, get their memory from "Alloc", e.g.
+// ArenaAlloc<Data> (see myArena.h) to keep them in an arena. If the arena
+// is released by its owner anyway, the destructor does not free the
+// buckets one by one, and release() drops them all without a look.
+//
+template <class Data, class Hasher = DataHash<Data>,
+          class Equal = DataEqual<Data>, class Alloc = allocator<Data> >
 class HashSet
 {
+#define HASH_MAX_LOAD       4.0
+#define HASH_MIGRATE_STEP   8
+
 public:
-   HashSet(size_t b = 0) : _numBuckets(0), _buckets(nullptr) { if (b != 0) init(b); }
-   ~HashSet() { reset(); }
+   typedef vector<Data, Alloc>   Bucket;
+   typedef typename allocator_traits<Alloc>::template
+              rebind_alloc<Bucket>   BucketAlloc;
+
+   HashSet(size_t b = 0, const Hasher& h = Hasher(),
+           const Equal& e = Equal(), const Alloc& a = Alloc()) :
+      _hasher(h), _equal(e), _alloc(a), _numBuckets(0), _buckets(nullptr),
+      _numData(0), _maxLoad(HASH_MAX_LOAD), _incremental(false),
+      _oldNumBuckets(0), _oldBuckets(nullptr), _migrateIdx(0) {
+      if (b != 0) init(b); }
+   ~HashSet() {
+      bool bulk = bulkReleased(_alloc)
+                  && is_trivially_destructible<Data>::value;
+      freeBuckets(_buckets, _numBuckets, bulk);
+      freeBuckets(_oldBuckets, _oldNumBuckets, bulk);
+   }
 
    // TODO: implement the HashSet<Data>::iterator
    // o An iterator should be able to go through all the valid Data
@@ -46,11 +91,12 @@ public:
    //
    class iterator
    {
-     friend class HashSet<Data>;
+     friend class HashSet<Data, Hasher, Equal, Alloc>;
 
      public:
-     iterator( const typename vector<Data>::iterator& it,
-              size_t s = 0, HashSet<Data>* const ptr = nullptr):
+     iterator( const typename Bucket::iterator& it,
+              size_t s = 0,
+              HashSet<Data, Hasher, Equal, Alloc>* const ptr = nullptr):
        _itor( it), _bucketIdx(s), _caller(ptr) {}
 
      iterator() :
@@ -65,34 +111,56 @@ public:
      bool operator != (const iterator& i) const ;
      bool operator == (const iterator& i) const ;
      private:
-     typename vector<Data>::iterator _itor;
+     typename Bucket::iterator       _itor;
      size_t                          _bucketIdx;
-     HashSet<Data>*                  _caller;
+     HashSet<Data, Hasher, Equal, Alloc>*   _caller;
    };
 
-   void init(size_t b) { _numBuckets = b; _buckets = new vector<Data>[b]; }
+   void init(size_t b) {
+     reset(); _numBuckets = b; _buckets = newBuckets(b);
+     _used.assign((b + 63) / 64, 0); }
    void reset() {
-     _numBuckets = 0;
-     if (_buckets) { delete [] _buckets; _buckets = nullptr; }
+     freeBuckets(_buckets, _numBuckets); _buckets = nullptr;
+     _numBuckets = 0; _numData = 0;
+     _used.clear();
+     dropOld();
    }
    void clear() {
-     for (size_t i = 0; i < _numBuckets; ++i) _buckets[i].clear();
+     for (size_t i = nextUsed(_used, 0, _numBuckets); i < _numBuckets;
+          i = nextUsed(_used, i + 1, _numBuckets))
+        _buckets[i].clear();
+     fill(_used.begin(), _used.end(), 0);
+     _numData = 0;
+     dropOld();
+   }
+   // same as reset(), but nothing is freed: for the owner of the
+   // allocator, which then frees all its memory at once
+   void release() {
+     assert(bulkReleased(_alloc) && is_trivially_destructible<Data>::value);
+     _buckets = _oldBuckets = nullptr;
+     _numBuckets = _oldNumBuckets = _migrateIdx = 0; _numData = 0;
+     _used.clear(); _oldUsed.clear();
    }
    size_t numBuckets() const { return _numBuckets; }
 
-   vector<Data>& operator [] (size_t i) { return _buckets[i]; }
-   const vector<Data>& operator [](size_t i) const { return _buckets[i]; }
+   // 0 ==> never grow
+   double maxLoadFactor() const { return _maxLoad; }
+   void setMaxLoadFactor(double f) { _maxLoad = f; }
+   bool incremental() const { return _incremental; }
+   // grow now so that n data fit without growing again
+   void reserve(size_t n) ;
+   void setIncremental(bool i) { _incremental = i; if (!i) migrateAll(); }
+
+   const Bucket& operator [](size_t i) const { return _buckets[i]; }
 
-   // TODO: implement these functions
-   //
    // Point to the first valid data
    iterator begin() const ;
    // Pass the end
    iterator end() const ;
    // return true if no valid data
-   bool empty() const ;
+   bool empty() const { return _numData == 0; }
    // number of valid data
-   size_t size() const ;
+   size_t size() const { return _numData; }
 
    // check if d is in the hash...
    // if yes, return true;
@@ -115,82 +183,317 @@ public:
 
    // return true if removed successfully (i.e. d is in the hash)
    // return fasle otherwise (i.e. nothing is removed)
-   bool remove(const Data& d) ;
-
-   // =============helper functions============================
+   bool remove(const Data& d) { return removeKey(d); }
+
+   // same as insert(), for a d known not to be in the hash; so d is not
+   // looked for
+   void insertNew(const Data& d) ;
+
+   // the data in the hash equal to k; nullptr if not found.
+   // the pointer is valid until the next insert/update/remove.
+   template <class Key> const Data* findKey(const Key& k) const ;
+   // same as remove(), but by key; if d != 0, the data removed is copied
+   // to *d
+   template <class Key> bool removeKey(const Key& k, Data* d = 0) ;
+
+   // For snapshots: places() gives where every data sits, in the order
+   // of the iterators; adopt() rebuilds the same table of b buckets from
+   // the data and their places, without hashing or comparing any.
+   // adopt() returns false, leaving the hash empty, if a place is not in
+   // a table of b buckets.
+   void places(vector<uint64_t>& p) const ;
+   bool adopt(size_t b, const Data* d, const uint64_t* p, size_t n) ;
 
 private:
-   // Do not add any extra data member
+   Hasher            _hasher;
+   Equal             _equal;
+   Alloc             _alloc;
    size_t            _numBuckets;
-   vector<Data>*     _buckets;
+   Bucket*           _buckets;
+   size_t            _numData;
+   double            _maxLoad;
+   bool              _incremental;
+
+   // buckets before the last growth; [0, _migrateIdx) are migrated
+   size_t            _oldNumBuckets;
+   Bucket*           _oldBuckets;
+   size_t            _migrateIdx;
+
+   // bit i is set iff bucket i is not empty
+   vector<size_t>    _used;
+   vector<size_t>    _oldUsed;
+
+   template <class Key>
+   size_t bucketNum(const Key& k) const {
+     return (_hasher(k) % _numBuckets); }
+
+   // =============helper functions============================
 
-   size_t bucketNum(const Data& d) const {
-     return (d() % _numBuckets); }
+   // the iterator goes through the new buckets, then the old ones
+   size_t totalBuckets() const { return _numBuckets + _oldNumBuckets; }
+   Bucket& bucket(size_t i) const {
+     return (i < _numBuckets)? _buckets[i]: _oldBuckets[i - _numBuckets]; }
+   // first non-empty bucket >= i; totalBuckets() if none
+   size_t nextBucket(size_t i) const ;
+   // last non-empty bucket < i; size_t(-1) if none
+   size_t prevBucket(size_t i) const ;
+
+   static void setUsed(vector<size_t>& bits, size_t i) {
+     bits[i >> 6] |= size_t(1) << (i & 63); }
+   static void resetUsed(vector<size_t>& bits, size_t i) {
+     bits[i >> 6] &= ~(size_t(1) << (i & 63)); }
+   static size_t nextUsed(const vector<size_t>& bits, size_t i, size_t n) ;
+   static size_t prevUsed(const vector<size_t>& bits, size_t i) ;
+
+   template <class Key>
+   typename Bucket::iterator
+   findIn(Bucket& b, const Key& k) const {
+     auto it = b.begin();
+     while( it != b.end() && !_equal(*it, k) ) ++it;
+     // the number of data compared with k
+     MY_STATS_COUNT("HashSet probes", (it - b.begin()) + (it != b.end()));
+     return it;
+   }
+   // the bucket that holds k, or the one k should go to if not found
+   template <class Key> Bucket* findBucket(const Key& k) const ;
+   // called before k is inserted/updated/removed; return the bucket
+   // where k is to be inserted into or removed from
+   template <class Key> Bucket* prepare(const Key& k) ;
+   void grow() ;
+   void growTo(size_t b) ;
+   void migrate(size_t oldIdx) ;
+   void migrateAll() ;
+   // the bucket array is from _alloc too, holding a Bucket on it each
+   Bucket* newBuckets(size_t b) const {
+     Bucket* p = BucketAlloc(_alloc).allocate(b);
+     for (size_t i = 0; i < b; ++i) new (p + i) Bucket(_alloc);
+     return p; }
+   // with "bulk", the buckets and the array are left to the allocator
+   void freeBuckets(Bucket* p, size_t b, bool bulk = false) const {
+     if (p == nullptr || bulk) return;
+     for (size_t i = 0; i < b; ++i) p[i].~Bucket();
+     BucketAlloc(_alloc).deallocate(p, b); }
+   void dropOld() {
+     freeBuckets(_oldBuckets, _oldNumBuckets); _oldBuckets = nullptr;
+     _oldNumBuckets = _migrateIdx = 0;
+     _oldUsed.clear();
+   }
 };
 
-template < typename T>
-  bool
-HashSet<T>::insert( const T& other )
+template <typename T, typename H, typename E, typename A>
+size_t
+HashSet<T, H, E, A>::nextUsed( const vector<size_t>& bits, size_t i, size_t n )
 {
-  // check if bucket valid first.
-  if( _buckets == nullptr )
-    _buckets = new vector<T> [ _numBuckets] ;
+  if( i >= n )
+    return n;
+  size_t w = i >> 6;
+  size_t word = bits[w] & ( ~size_t(0) << (i & 63) );
+  while( word == 0 )
+  {
+    if( ++w == bits.size() )
+      return n;
+    word = bits[w];
+  }
+  return (w << 6) + __builtin_ctzll( word );
+}
 
-  // check if exactly the same element.
-  auto* bucketPtr = _buckets + bucketNum(other);
-  auto  itor = find( bucketPtr->begin(), bucketPtr->end(), other );
-  if( itor != bucketPtr -> end () )
+template <typename T, typename H, typename E, typename A>
+size_t
+HashSet<T, H, E, A>::prevUsed( const vector<size_t>& bits, size_t i )
+{
+  if( i-- == 0 )
+    return size_t(-1);
+  size_t w = i >> 6;
+  size_t word = bits[w] & ( ~size_t(0) >> (63 - (i & 63)) );
+  while( word == 0 )
   {
-    return false;
+    if( w-- == 0 )
+      return size_t(-1);
+    word = bits[w];
   }
+  return (w << 6) + 63 - __builtin_clzll( word );
+}
 
-  bucketPtr->push_back( other);
-  return true;
+template <typename T, typename H, typename E, typename A>
+size_t
+HashSet<T, H, E, A>::nextBucket( size_t i ) const
+{
+  if( i < _numBuckets )
+  {
+    size_t j = nextUsed( _used, i, _numBuckets );
+    if( j < _numBuckets )
+      return j;
+    i = _numBuckets;
+  }
+  return _numBuckets + nextUsed( _oldUsed, i - _numBuckets, _oldNumBuckets );
 }
 
-template < typename T>
+template <typename T, typename H, typename E, typename A>
 size_t
-HashSet<T>::size() const
+HashSet<T, H, E, A>::prevBucket( size_t i ) const
+{
+  if( i > _numBuckets )
+  {
+    size_t j = prevUsed( _oldUsed, i - _numBuckets );
+    if( j != size_t(-1) )
+      return _numBuckets + j;
+    i = _numBuckets;
+  }
+  return prevUsed( _used, i );
+}
+
+template <typename T, typename H, typename E, typename A>
+template <class K>
+typename HashSet<T, H, E, A>::Bucket*
+HashSet<T, H, E, A>::findBucket( const K& other ) const
+{
+  if( _oldBuckets != nullptr )
+  {
+    auto* oldPtr = _oldBuckets + _hasher(other) % _oldNumBuckets;
+    if( findIn( *oldPtr, other ) != oldPtr->end() )
+      return oldPtr;
+  }
+  return _buckets + bucketNum(other);
+}
+
+template <typename T, typename H, typename E, typename A>
+template <class K>
+typename HashSet<T, H, E, A>::Bucket*
+HashSet<T, H, E, A>::prepare( const K& other )
 {
   if( _buckets == nullptr )
-    return 0;
-  size_t ret = 0;
-  for( size_t i = 0; i < _numBuckets; ++i )
-    ret += _buckets[i].size();
-  return ret;
+    init( getNextHashSize( _numBuckets ) );
+  if( _oldBuckets != nullptr )
+  {
+    // move d's old bucket first, then make progress on the rest
+    migrate( _hasher(other) % _oldNumBuckets );
+    for( size_t i = 0; i < HASH_MIGRATE_STEP && _oldBuckets; ++i )
+      migrate( _migrateIdx );
+  }
+  return _buckets + bucketNum(other);
 }
 
-template < typename T>
-bool
-HashSet<T>::empty() const
+template <typename T, typename H, typename E, typename A>
+void
+HashSet<T, H, E, A>::grow()
 {
+  if( _maxLoad <= 0 || _numData <= _numBuckets * _maxLoad )
+    return;
+  growTo( getNextHashSize( _numBuckets ) );
+}
+
+template <typename T, typename H, typename E, typename A>
+void
+HashSet<T, H, E, A>::reserve( size_t n )
+{
+  if( _maxLoad <= 0 || n <= _numBuckets * _maxLoad )
+    return;
+  size_t b = _numBuckets;
+  do b = getNextHashSize( b ); while( n > b * _maxLoad );
   if( _buckets == nullptr )
-    return true;
-  for( size_t i = 0; i < _numBuckets; ++i )
-    if( !_buckets[i].empty() )
-      return true;
-  return false;
+    init( b );
+  else
+    growTo( b );
 }
 
-template< typename T>
+template <typename T, typename H, typename E, typename A>
+void
+HashSet<T, H, E, A>::growTo( size_t b )
+{
+  migrateAll();
+  _oldNumBuckets = _numBuckets;
+  _oldBuckets = _buckets;
+  _migrateIdx = 0;
+  _oldUsed.swap( _used );
+  _numBuckets = b;
+  _buckets = newBuckets( _numBuckets );
+  _used.assign( (_numBuckets + 63) / 64, 0 );
+  if( !_incremental )
+    migrateAll();
+}
+
+template <typename T, typename H, typename E, typename A>
+void
+HashSet<T, H, E, A>::migrate( size_t oldIdx )
+{
+  Bucket& ob = _oldBuckets[oldIdx];
+  for( size_t i = 0; i < ob.size(); ++i )
+  {
+    size_t b = bucketNum(ob[i]);
+    _buckets[b].push_back( ob[i] );
+    setUsed( _used, b );
+  }
+  Bucket( _alloc ).swap( ob );
+  resetUsed( _oldUsed, oldIdx );
+  // skip the buckets that are done
+  _migrateIdx = nextUsed( _oldUsed, _migrateIdx, _oldNumBuckets );
+  if( _migrateIdx == _oldNumBuckets )
+    dropOld();
+}
+
+template <typename T, typename H, typename E, typename A>
+void
+HashSet<T, H, E, A>::migrateAll()
+{
+  while( _oldBuckets != nullptr )
+    migrate( _migrateIdx );
+}
+
+template <typename T, typename H, typename E, typename A>
+  bool
+HashSet<T, H, E, A>::insert( const T& other )
+{
+  MY_STATS_LATENCY( "HashSet::insert" );
+  // check if exactly the same element.
+  auto* bucketPtr = prepare( other );
+  auto  itor = findIn( *bucketPtr, other );
+  if( itor != bucketPtr -> end () )
+  {
+    return false;
+  }
+
+  bucketPtr->push_back( other);
+  setUsed( _used, bucketPtr - _buckets );
+  ++_numData;
+  grow();
+  return true;
+}
+
+template <typename T, typename H, typename E, typename A>
+void
+HashSet<T, H, E, A>::insertNew( const T& other )
+{
+  MY_STATS_LATENCY( "HashSet::insertNew" );
+  auto* bucketPtr = prepare( other );
+  assert( findIn( *bucketPtr, other ) == bucketPtr->end() );
+  bucketPtr->push_back( other );
+  setUsed( _used, bucketPtr - _buckets );
+  ++_numData;
+  grow();
+}
+
+template <typename T, typename H, typename E, typename A>
 bool
-HashSet<T>::check( const T& other ) const
+HashSet<T, H, E, A>::check( const T& other ) const
 {
+  MY_STATS_LATENCY( "HashSet::check" );
   if( _buckets == nullptr )
     return false;
-  auto* bucketPtr = _buckets + bucketNum(other) ;
-  return ( bucketPtr->find( other ) == bucketPtr -> end()  );
+  auto* bucketPtr = findBucket( other ) ;
+  return ( findIn( *bucketPtr, other )
+           != bucketPtr -> end() );
 }
 
-template <typename T>
+template <typename T, typename H, typename E, typename A>
 bool
-HashSet<T>::query( T& other ) const
+HashSet<T, H, E, A>::query( T& other ) const
 {
+  MY_STATS_LATENCY( "HashSet::query" );
   if( _buckets == nullptr )
     return false;
 
-  auto* bucketPtr = _buckets + bucketNum(other) ;
-  auto  itor = find( bucketPtr->begin(), bucketPtr->end(), other );
+  auto* bucketPtr = findBucket( other ) ;
+  auto  itor = findIn( *bucketPtr, other );
 
   if( itor != bucketPtr -> end() )
   {
@@ -200,105 +503,170 @@ HashSet<T>::query( T& other ) const
   return false;
 }
 
-template <typename T>
+template <typename T, typename H, typename E, typename A>
   bool
-HashSet<T>::update( const T& other )
+HashSet<T, H, E, A>::update( const T& other )
 {
-  if( _buckets == nullptr )
-    return false;
-
-  auto* bucketPtr = _buckets + bucketNum(other) ;
-  auto  itor = find( bucketPtr->begin(), bucketPtr->end(), other );
+  MY_STATS_LATENCY( "HashSet::update" );
+  auto* bucketPtr = prepare( other ) ;
+  auto  itor = findIn( *bucketPtr, other );
   if( itor != bucketPtr -> end() )
   {
     (*itor) = other;
     return true;
   }
   bucketPtr->push_back( other);
+  setUsed( _used, bucketPtr - _buckets );
+  ++_numData;
+  grow();
   return false;
 }
 
-template <typename T>
+template <typename T, typename H, typename E, typename A>
+template <class K>
+const T*
+HashSet<T, H, E, A>::findKey( const K& other ) const
+{
+  MY_STATS_LATENCY( "HashSet::findKey" );
+  if( _buckets == nullptr )
+    return nullptr;
+  auto* bucketPtr = findBucket( other ) ;
+  auto  itor = findIn( *bucketPtr, other );
+  return ( itor != bucketPtr->end() )? &(*itor): nullptr;
+}
+
+template <typename T, typename H, typename E, typename A>
+template <class K>
   bool
-HashSet<T>::remove( const T& other ) 
+HashSet<T, H, E, A>::removeKey( const K& other, T* d )
 {
+  MY_STATS_LATENCY( "HashSet::removeKey" );
   if( _buckets == nullptr )
     return false;
-  auto* bucketPtr = _buckets + bucketNum(other) ;
+  auto* bucketPtr = prepare( other ) ;
   for( auto it = bucketPtr->begin(); it != bucketPtr->end(); ++it )
   {
-    if( *it == other )
+    if( _equal( *it, other ) )
     {
+      if( d != 0 )
+        *d = *it;
       // swap( (*it), (*(bucketPtr->end() -1) ) );
       // bucketPtr -> pop_back();
       bucketPtr->erase(it);
+      if( bucketPtr->empty() )
+        resetUsed( _used, bucketPtr - _buckets );
+      --_numData;
       return true;
     }
   }
   return false;
 }
 
-template <typename T>
-typename HashSet<T>::iterator
-HashSet<T>::begin() const 
+// a place is a bucket; the data not yet migrated get the bucket they are
+// going to
+template <typename T, typename H, typename E, typename A>
+void
+HashSet<T, H, E, A>::places( vector<uint64_t>& p ) const
 {
-  if( _buckets == nullptr )
-    return vector<T>().begin();
-  else
+  p.clear();
+  p.reserve( _numData );
+  for( size_t i = nextBucket( 0 ); i < totalBuckets(); i = nextBucket( i+1 ) )
+  {
+    const Bucket& b = bucket(i);
+    for( size_t j = 0; j < b.size(); ++j )
+      p.push_back( ( i < _numBuckets )? i: bucketNum( b[j] ) );
+  }
+}
+
+template <typename T, typename H, typename E, typename A>
+bool
+HashSet<T, H, E, A>::adopt( size_t b, const T* d, const uint64_t* p, size_t n )
+{
+  init( b );
+  // size every bucket once, instead of growing it data by data
+  vector<uint32_t> sizes( b, 0 );
+  for( size_t k = 0; k < n; ++k )
   {
-    size_t i = 0;
-    for( ; i < _numBuckets; ++i )
+    if( p[k] >= b )
     {
-      if( !( _buckets[i].empty() ) )
-        break;
+      init( b );
+      return false;
     }
-    if( i == _numBuckets )
+    ++sizes[p[k]];
+  }
+  for( size_t i = 0; i < b; ++i )
+    if( sizes[i] != 0 )
+    {
+      _buckets[i].reserve( sizes[i] );
+      setUsed( _used, i );
+    }
+  for( size_t k = 0; k < n; ++k )
+    _buckets[p[k]].push_back( d[k] );
+  _numData = n;
+  return true;
+}
+
+template <typename T, typename H, typename E, typename A>
+typename HashSet<T, H, E, A>::iterator
+HashSet<T, H, E, A>::begin() const 
+{
+  if( _buckets == nullptr )
+    return iterator();
+  else
+  {
+    size_t i = nextBucket( 0 );
+    if( i == totalBuckets() )
       return end();
-    return iterator( _buckets[i].begin(),
+    return iterator( bucket(i).begin(),
                     i,
-                    const_cast<HashSet<T>*> (this) );
+                    const_cast<HashSet<T, H, E, A>*> (this) );
   }
 }
 
-template <typename T>
-typename HashSet<T>::iterator
-HashSet<T>::end() const 
+template <typename T, typename H, typename E, typename A>
+typename HashSet<T, H, E, A>::iterator
+HashSet<T, H, E, A>::end() const 
 {
   if( _buckets == nullptr )
-    return vector<T>().end();
+    return iterator();
   else
-    return iterator(_buckets[_numBuckets-1].end(),
-                    _numBuckets-1,
-                    const_cast<HashSet<T>*> (this) );
+    return iterator(bucket(totalBuckets()-1).end(),
+                    totalBuckets()-1,
+                    const_cast<HashSet<T, H, E, A>*> (this) );
 }
 
-template <typename T>
+template <typename T, typename H, typename E, typename A>
 const T&
-HashSet<T>::iterator::operator * () const 
+HashSet<T, H, E, A>::iterator::operator * () const 
 {
   return (*_itor);
 }
 
-template <typename T>
-  typename HashSet<T>::iterator&
-HashSet<T>::iterator::operator ++ () // pre-increment operator
+template <typename T, typename H, typename E, typename A>
+  typename HashSet<T, H, E, A>::iterator&
+HashSet<T, H, E, A>::iterator::operator ++ () // pre-increment operator
 {
   if( _caller == nullptr )
     return (*this);
 
   _itor++;
-  while( _itor == (*_caller)[_bucketIdx].end()
-        && _bucketIdx < _caller->numBuckets()-1 )
+  if( _itor == _caller->bucket(_bucketIdx).end() )
   {
-    ++ _bucketIdx;
-    _itor = (*_caller)[_bucketIdx].begin() ;
+    size_t next = _caller->nextBucket( _bucketIdx + 1 );
+    if( next == _caller->totalBuckets() )
+      (*this) = _caller->end();
+    else
+    {
+      _bucketIdx = next;
+      _itor = _caller->bucket(_bucketIdx).begin() ;
+    }
   }
   return (*this);
 }
 
-template <typename T>
-  typename HashSet<T>::iterator
-HashSet<T>::iterator::operator ++ (int dummy) 
+template <typename T, typename H, typename E, typename A>
+  typename HashSet<T, H, E, A>::iterator
+HashSet<T, H, E, A>::iterator::operator ++ (int dummy) 
   // post-increment operator
 {
   if( _caller == nullptr )
@@ -309,26 +677,28 @@ HashSet<T>::iterator::operator ++ (int dummy)
   return tmp;
 }
 
-template <typename T>
-  typename HashSet<T>::iterator&
-HashSet<T>::iterator::operator -- () // pre-decrement operator
+template <typename T, typename H, typename E, typename A>
+  typename HashSet<T, H, E, A>::iterator&
+HashSet<T, H, E, A>::iterator::operator -- () // pre-decrement operator
 {
   if( _caller == nullptr )
     return (*this);
 
-  while( _itor == (*_caller)[_bucketIdx].begin() 
-        && _bucketIdx > 0)
+  if( _itor == _caller->bucket(_bucketIdx).begin() )
   {
-    _bucketIdx --;
-    _itor = (*_caller ) [_bucketIdx].end();
+    size_t prev = _caller->prevBucket( _bucketIdx );
+    if( prev == size_t(-1) )
+      return (*this);
+    _bucketIdx = prev;
+    _itor = _caller->bucket(_bucketIdx).end();
   }
   _itor--;
   return (*this);
 }
 
-template <typename T>
-  typename HashSet<T>::iterator
-HashSet<T>::iterator::operator -- (int dummy) 
+template <typename T, typename H, typename E, typename A>
+  typename HashSet<T, H, E, A>::iterator
+HashSet<T, H, E, A>::iterator::operator -- (int dummy) 
   // post-decrement operator
 {
   if( _caller == nullptr )
@@ -339,26 +709,29 @@ HashSet<T>::iterator::operator -- (int dummy)
   return tmp;
 }
 
-template <typename T>
+template <typename T, typename H, typename E, typename A>
 bool
-HashSet<T>::iterator::operator == ( const HashSet<T>::iterator&
-                                   other_itor ) const
+HashSet<T, H, E, A>::iterator::operator == (
+  const HashSet<T, H, E, A>::iterator& other_itor ) const
 {
-  return ( (_itor) == (other_itor._itor) );
+  // buckets may be adjacent in memory (e.g. in an arena), so that the
+  // end of one is the begin of another: check the bucket too
+  return ( (_itor) == (other_itor._itor)
+           && _bucketIdx == other_itor._bucketIdx );
 }
 
-template <typename T>
+template <typename T, typename H, typename E, typename A>
 bool
-HashSet<T>::iterator::operator != ( const HashSet<T>::iterator&
-                                   other_itor ) const
+HashSet<T, H, E, A>::iterator::operator != (
+  const HashSet<T, H, E, A>::iterator& other_itor ) const
 {
   return ( ! ( operator == ( other_itor ) ) );
 }
 
-template <typename T>
-typename HashSet<T>::iterator&
-HashSet<T>::iterator::operator = ( const HashSet<T>::iterator&
-                                  other_itor )
+template <typename T, typename H, typename E, typename A>
+typename HashSet<T, H, E, A>::iterator&
+HashSet<T, H, E, A>::iterator::operator = (
+  const HashSet<T, H, E, A>::iterator& other_itor )
 {
   if( this != &other_itor )
   {
@@ -366,6 +739,7 @@ HashSet<T>::iterator::operator = ( const HashSet<T>::iterator&
     _bucketIdx = other_itor._bucketIdx;
     _caller    = other_itor._caller;
   }
+  return (*this);
 }
 
 #endif // MY_HASH_SET_H
@@ -12,8 +12,49 @@
 #include <algorithm>
 #include <vector>
 #include <utility>
+#include <new>
+#include <cstdlib>
+#include <stdint.h>
+#include "myStats.h"
 
-template <class Data>
+#define CACHE_LINE_SIZE 64
+
+//------------------------------
+// Cache line aligned allocator
+//------------------------------
+template <class T>
+struct CacheAlignedAlloc
+{
+   typedef T value_type;
+
+   CacheAlignedAlloc() {}
+   template <class U> CacheAlignedAlloc(const CacheAlignedAlloc<U>&) {}
+
+   T* allocate(size_t n) {
+      void* p = 0;
+      if (posix_memalign(&p, CACHE_LINE_SIZE, n * sizeof(T)) != 0)
+         throw bad_alloc();
+      return static_cast<T*>(p);
+   }
+   void deallocate(T* p, size_t) { free(p); }
+};
+
+template <class T, class U>
+bool operator == (const CacheAlignedAlloc<T>&, const CacheAlignedAlloc<U>&)
+{ return true; }
+template <class T, class U>
+bool operator != (const CacheAlignedAlloc<T>&, const CacheAlignedAlloc<U>&)
+{ return false; }
+
+//---------------------
+// Define MinHeap class
+//---------------------
+// "D" is the arity of the heap: the children of slot i are the D
+// consecutive slots D*i+1 ... D*i+D. A wider heap is shallower, so a
+// sift down touches fewer cache lines, at the cost of D-1 comparisons
+// per level instead of 1.
+//
+template <class Data, size_t D = 2>
 class MinHeap
 {
 public:
@@ -35,67 +76,108 @@ public:
    void delMin();
    void delData(size_t );
 
-   // fixing ill-formed heap caused by deletion.
-   // shall not be used to fix update of node.
+   // the key of _data[i] has been changed in place (e.g. via operator[]);
+   // sift it up or down to restore the heap order.
+   void updateKey(size_t i);
+
+   // fixing ill-formed heap below idx, i.e. after deletion or after
+   // the key of _data[idx] is increased.
    void heapFixDown( size_t idx = 0);
+   void heapFixUp( size_t idx);
 
 private:
-   // DO NOT add or change data members
    vector<Data>   _data;
 
    // helper functions.
    
    // 0 begin root of the heap.
-   // (2*n)+1 --> left child.
-   // (2*n)+2 --> right child.
+   // (D*n)+1 --> first child.
+   // (D*n)+D --> last child.
+   static size_t parent( size_t i) { return (i-1)/D; }
+   static size_t child( size_t i) { return D*i + 1; }
 };
 
-template <typename T>
+template <typename T, size_t D>
 const T&
-MinHeap<T>::min() const
+MinHeap<T, D>::min() const
 {
   return (*(_data.begin()));
 }
 
-template <typename T>
+template <typename T, size_t D>
 void
-MinHeap<T>::insert( const T& other )
+MinHeap<T, D>::insert( const T& other )
 {
+  MY_STATS_LATENCY( "MinHeap::insert" );
+  MY_STATS_ONLY( size_t depth = 0; )
   size_t s = _data.size();
   size_t parent;
   _data.push_back( other );
   while( s != 0 )
   {
-    parent = (s-1)/2;
+    parent = MinHeap::parent( s );
     if( !(other < _data[parent] ) )
       break;
     _data[s] = _data[parent] ;
     s = parent;
+    MY_STATS_ONLY( ++depth; )
   }
   _data[s] = other;
+  MY_STATS_COUNT( "MinHeap sift up", depth );
 }
 
-template <typename T>
+template <typename T, size_t D>
 void
-MinHeap<T>::delMin()
+MinHeap<T, D>::delMin()
 {
   swap( _data[0], _data[_data.size()-1] );
   _data.pop_back();
   heapFixDown();
 }
 
-template <typename T>
+template <typename T, size_t D>
 void
-MinHeap<T>::delData( size_t s )
+MinHeap<T, D>::delData( size_t s )
 {
+  MY_STATS_LATENCY( "MinHeap::delData" );
   swap( _data[s], _data[_data.size()-1] );
   _data.pop_back();
-  heapFixDown( s );
+  // the moved-in last element may also be smaller than its new parent
+  if( s < _data.size() )
+    updateKey( s );
+}
+
+template <typename T, size_t D>
+void
+MinHeap<T, D>::updateKey( size_t i )
+{
+  MY_STATS_LATENCY( "MinHeap::updateKey" );
+  if( i != 0 && _data[i] < _data[parent(i)] )
+    heapFixUp( i );
+  else
+    heapFixDown( i );
 }
 
-template <typename T>
+template <typename T, size_t D>
 void
-MinHeap<T>::heapFixDown( size_t idx)
+MinHeap<T, D>::heapFixUp( size_t idx)
+{
+  MY_STATS_ONLY( size_t depth = 0; )
+  while( idx != 0 )
+  {
+    size_t p = parent( idx );
+    if( !( _data[idx] < _data[p] ) )
+      break;
+    swap( _data[idx], _data[p] );
+    idx = p;
+    MY_STATS_ONLY( ++depth; )
+  }
+  MY_STATS_COUNT( "MinHeap sift up", depth );
+}
+
+template <typename T, size_t D>
+void
+MinHeap<T, D>::heapFixDown( size_t idx)
 {
   // just fix downwards.
   // other part of the heap is still in valid state,
@@ -103,22 +185,427 @@ MinHeap<T>::heapFixDown( size_t idx)
   if( !( idx<_data.size()) )
     return;
 
-  while (idx < _data.size())
+  MY_STATS_ONLY( size_t depth = 0; )
+  size_t n = _data.size();
+  for( size_t c = child( idx ); c < n; c = child( idx ) )
   {
-    size_t tmp     = idx;
-    size_t childL  = 2*idx + 1;
-    size_t childR  = 2*idx + 2;
-    if( childL < _data.size() )
-      if( _data[childL] < _data[tmp] )
-        tmp = childL;
-    if( childR < _data.size() )
-      if( _data[childR] < _data[tmp] )
-        tmp = childR;
-    if( tmp == idx )
+    // the smallest of the (at most D) children
+    size_t tmp = c;
+    for( size_t e = std::min( c + D, n ); ++c < e; )
+      if( _data[c] < _data[tmp] )
+        tmp = c;
+    if( !( _data[tmp] < _data[idx] ) )
       break;
     swap( _data[idx], _data[tmp] );
     idx = tmp;
+    MY_STATS_ONLY( ++depth; )
   }
+  MY_STATS_COUNT( "MinHeap sift down", depth );
 }
 
+//---------------------------
+// Define HandleMinHeap class
+//---------------------------
+// A min heap of 32-bit handles chosen by the owner, typically indices
+// into the owner's own array of records. Used as IdxMinHeap or
+// KeyMinHeap (below), which differ only in "Slots", the array of the
+// heap slots, i.e. in how the order of two handles is read.
+//
+// The slot of every handle is kept up to date while sifting, so that an
+// arbitrary element can be located and removed in O(log n) without
+// scanning the slots.
+//
+// After the key of a handle is changed by the owner, updateKey() (or
+// increaseKeys()) must be called on its slot before any other operation.
+//
+// Handles of equal keys are ordered by the handles themselves, so min()
+// is the same whatever the order of the earlier operations.
+//
+// "D" is the arity as in MinHeap. The slots are cache line aligned and
+// start with D-1 padding entries, so that the D children of every slot
+// are contiguous and start at a multiple of D in memory; with D = 16 the
+// children of a slot are exactly one cache line.
+//
+// "Slots" holds what moves with a handle while sifting ("Slots::Entry"):
+//    Entry entry(uint32_t h) const        h, with its current key
+//    static uint32_t handle(const Entry&)
+//    bool less(const Entry&, const Entry&) const
+//                                         by key, then by handle
+//    Entry get(size_t i) const, void set(size_t i, const Entry&)
+//    size_t minChild(size_t c, size_t e) const
+//                                         slot of the smallest in [c, e)
+// plus size(), push_back(), pop_back(), resize() and reserve() on the
+// slots (without the padding), and name() for the statistics.
+//
+template <class Slots, size_t D>
+class HandleMinHeap
+{
+public:
+   typedef typename Slots::Policy   Policy;
+
+   HandleMinHeap(const Policy& p = Policy(), size_t s = 0) : _slots(p) {
+      if (s != 0) { _slots.reserve(s); _pos.reserve(s); }
+   }
+   ~HandleMinHeap() {}
+
+   void clear() { _slots.resize(0); _pos.clear(); }
+
+   // the handle in heap slot i
+   uint32_t operator [] (size_t i) const { return at(i); }
+
+   size_t size() const { return _slots.size(); }
+
+   // slot of handle h; h must be in the heap
+   size_t slot(uint32_t h) const { return _pos[h]; }
+
+   uint32_t min() const { return at(0); }
+   void insert(uint32_t h);
+   // insert all of hs; many of them are appended and heapified at once
+   void insertAll(const vector<uint32_t>& hs);
+   void delMin() { delData(0); }
+   void delData(size_t i);
+   void delHandle(uint32_t h) { delData(_pos[h]); }
+   // delete all of hs (distinct handles in the heap); many of them are
+   // dropped in one pass over the array, followed by one heapify.
+   void delHandles(const vector<uint32_t>& hs);
+
+   // see MinHeap::updateKey()
+   void updateKey(size_t i);
+   // keys of all the slots in "slots" have been increased in place;
+   // "slots" will be sorted.
+   void increaseKeys(vector<size_t>& slots);
+
+   // collect the slots of all handles h with notAbove(h) == true.
+   // notAbove() must be monotone in the heap order, e.g. "key <= bound";
+   // the slots found always form a subtree hanging from the root.
+   template <class Pred>
+   void collect(Pred notAbove, vector<size_t>& slots) const;
+
+   // rebuild the heap order of the whole array (Floyd), O(n)
+   void heapify();
+
+   void heapFixDown( size_t idx = 0);
+   void heapFixUp( size_t idx);
+
+protected:
+   typedef typename Slots::Entry   Entry;
+
+   Slots              _slots;      // slot --> handle (and key)
+   vector<uint32_t>   _pos;        // handle --> slot
+
+   // helper functions.
+   static size_t parent( size_t i) { return (i-1)/D; }
+   static size_t child( size_t i) { return D*i + 1; }
+   uint32_t at( size_t i) const { return Slots::handle( _slots.get(i) ); }
+   void place( size_t i, const Entry& e) {
+     _slots.set( i, e ); _pos[Slots::handle(e)] = i; }
+   // sift slot i up or down
+   void fix( size_t i) {
+     if( i != 0 && _slots.less( _slots.get(i), _slots.get( parent(i) ) ) )
+       heapFixUp( i );
+     else heapFixDown( i ); }
+};
+
+template <typename S, size_t D>
+void
+HandleMinHeap<S, D>::insert( uint32_t h )
+{
+  MY_STATS_LATENCY( string( S::name() ) + "::insert" );
+  if( h >= _pos.size() )
+    _pos.resize( h+1 );
+  _slots.push_back( _slots.entry( h ) );
+  _pos[h] = size()-1;
+  heapFixUp( size()-1 );
+}
+
+template <typename S, size_t D>
+void
+HandleMinHeap<S, D>::insertAll( const vector<uint32_t>& hs )
+{
+  // Floyd is O(n+m); m inserts are O(m log n) at worst
+  if( hs.size() * 4 <= size() )
+  {
+    for( size_t i = 0; i < hs.size(); ++i )
+      insert( hs[i] );
+    return;
+  }
+  for( size_t i = 0; i < hs.size(); ++i )
+  {
+    if( hs[i] >= _pos.size() )
+      _pos.resize( hs[i]+1 );
+    _pos[hs[i]] = size();
+    _slots.push_back( _slots.entry( hs[i] ) );
+  }
+  heapify();
+}
+
+template <typename S, size_t D>
+void
+HandleMinHeap<S, D>::delData( size_t s )
+{
+  MY_STATS_LATENCY( string( S::name() ) + "::delData" );
+  size_t last = size()-1;
+  if( s != last )
+    place( s, _slots.get(last) );
+  _slots.pop_back();
+  // the moved-in last element may also be smaller than its new parent
+  if( s < size() )
+    fix( s );
+}
+
+template <typename S, size_t D>
+void
+HandleMinHeap<S, D>::delHandles( const vector<uint32_t>& hs )
+{
+  if( hs.size() * 4 <= size() )
+  {
+    for( size_t i = 0; i < hs.size(); ++i )
+      delHandle( hs[i] );
+    return;
+  }
+  // mark the victims, keep the others in place, then heapify
+  for( size_t i = 0; i < hs.size(); ++i )
+    _pos[hs[i]] = UINT32_MAX;
+  size_t n = 0;
+  for( size_t i = 0, e = size(); i < e; ++i )
+    if( _pos[at(i)] != UINT32_MAX )
+      place( n++, _slots.get(i) );
+  _slots.resize( n );
+  heapify();
+}
+
+template <typename S, size_t D>
+void
+HandleMinHeap<S, D>::updateKey( size_t i )
+{
+  MY_STATS_LATENCY( string( S::name() ) + "::updateKey" );
+  _slots.set( i, _slots.entry( at(i) ) );
+  fix( i );
+}
+
+template <typename S, size_t D>
+void
+HandleMinHeap<S, D>::increaseKeys( vector<size_t>& slots )
+{
+  for( size_t i = 0; i < slots.size(); ++i )
+    _slots.set( slots[i], _slots.entry( at( slots[i] ) ) );
+  // when most of the heap is touched a full rebuild is cheaper.
+  if( slots.size() * 4 > size() )
+  {
+    heapify();
+    return;
+  }
+  // bottom-up: the subtree below each slot is valid when it is fixed,
+  // and untouched ancestors stay no greater since keys only went up.
+  sort( slots.begin(), slots.end() );
+  for( size_t i = slots.size(); i != 0; --i )
+    heapFixDown( slots[i-1] );
+}
+
+template <typename S, size_t D>
+template <class Pred>
+void
+HandleMinHeap<S, D>::collect( Pred notAbove, vector<size_t>& slots ) const
+{
+  if( size() == 0 || !notAbove( at(0) ) )
+    return;
+  size_t begin = slots.size();
+  slots.push_back( 0 );
+  for( size_t i = begin; i < slots.size(); ++i )
+  {
+    size_t c = child( slots[i] );
+    for( size_t e = std::min( c + D, size() ); c < e; ++c )
+      if( notAbove( at(c) ) )
+        slots.push_back( c );
+  }
+}
+
+template <typename S, size_t D>
+void
+HandleMinHeap<S, D>::heapify()
+{
+  if( size() < 2 )
+    return;
+  for( size_t i = parent( size()-1 ) + 1; i != 0; --i )
+    heapFixDown( i-1 );
+}
+
+template <typename S, size_t D>
+void
+HandleMinHeap<S, D>::heapFixUp( size_t idx)
+{
+  // move the parents down into the hole, then drop e in
+  Entry e = _slots.get(idx);
+  MY_STATS_ONLY( size_t depth = 0; )
+  while( idx != 0 )
+  {
+    size_t p = parent( idx );
+    if( !_slots.less( e, _slots.get(p) ) )
+      break;
+    place( idx, _slots.get(p) );
+    idx = p;
+    MY_STATS_ONLY( ++depth; )
+  }
+  place( idx, e );
+  MY_STATS_COUNT( string( S::name() ) + " sift up", depth );
+}
+
+template <typename S, size_t D>
+void
+HandleMinHeap<S, D>::heapFixDown( size_t idx)
+{
+  Entry e = _slots.get(idx);
+  MY_STATS_ONLY( size_t depth = 0; )
+  size_t n = size();
+  for( size_t c = child( idx ); c < n; c = child( idx ) )
+  {
+    size_t tmp = _slots.minChild( c, std::min( c + D, n ) );
+    if( !_slots.less( _slots.get(tmp), e ) )
+      break;
+    place( idx, _slots.get(tmp) );
+    idx = tmp;
+    MY_STATS_ONLY( ++depth; )
+  }
+  place( idx, e );
+  MY_STATS_COUNT( string( S::name() ) + " sift down", depth );
+}
+
+//------------------------
+// Define IdxMinHeap class
+//------------------------
+// The heap never touches the records itself: "Compare" tells whether one
+// handle goes before another (e.g. by the load of the records they refer
+// to). The slots are the handles alone.
+//
+template <class Compare, size_t D>
+class IdxSlots
+{
+public:
+   typedef Compare    Policy;
+   typedef uint32_t   Entry;
+
+   IdxSlots(const Compare& c) : _less(c), _data(D-1) {}
+
+   static const char* name() { return "IdxMinHeap"; }
+   Entry entry(uint32_t h) const { return h; }
+   static uint32_t handle(Entry e) { return e; }
+   bool less(Entry a, Entry b) const {
+      return _less(a, b) || (!_less(b, a) && a < b); }
+
+   Entry get(size_t i) const { return _data[i + D-1]; }
+   void set(size_t i, Entry e) { _data[i + D-1] = e; }
+   size_t minChild(size_t c, size_t e) const {
+      size_t tmp = c;
+      for (size_t j = c+1; j < e; ++j)
+         if (less(get(j), get(tmp))) tmp = j;
+      return tmp;
+   }
+
+   size_t size() const { return _data.size() - (D-1); }
+   void push_back(Entry e) { _data.push_back(e); }
+   void pop_back() { _data.pop_back(); }
+   void resize(size_t n) { _data.resize(n + D-1); }
+   void reserve(size_t n) { _data.reserve(n + D-1); }
+
+private:
+   typedef vector<uint32_t, CacheAlignedAlloc<uint32_t> >  Handles;
+
+   Compare   _less;
+   Handles   _data;       // padding, then slot --> handle
+};
+
+template <class Compare, size_t D = 2>
+class IdxMinHeap : public HandleMinHeap<IdxSlots<Compare, D>, D>
+{
+public:
+   IdxMinHeap(const Compare& c = Compare(), size_t s = 0) :
+      HandleMinHeap<IdxSlots<Compare, D>, D>(c, s) {}
+};
+
+//------------------------
+// Define KeyMinHeap class
+//------------------------
+// Same as IdxMinHeap, but the heap keeps its own copy of the keys in a
+// dense array parallel to the handles (structure of arrays): sifting
+// compares and moves plain integers, and never looks at the owner's
+// records.
+//
+// "KeyOf" gives the key of a handle: "Key KeyOf::operator () (uint32_t)",
+// with "KeyOf::Key" an integer (or any cheap, "<"-comparable) type. It is
+// called once per insert() and once per slot passed to updateKey() or
+// increaseKeys(), to pick up the new key.
+//
+template <class KeyOf, size_t D>
+class KeySlots
+{
+public:
+   typedef KeyOf                 Policy;
+   typedef typename KeyOf::Key   Key;
+   struct Entry { Key _key; uint32_t _h; };
+
+   KeySlots(const KeyOf& k) : _keyOf(k), _keys(D-1), _data(D-1) {}
+
+   static const char* name() { return "KeyMinHeap"; }
+   Entry entry(uint32_t h) const { Entry e = { _keyOf(h), h }; return e; }
+   static uint32_t handle(const Entry& e) { return e._h; }
+   bool less(const Entry& a, const Entry& b) const {
+      return a._key < b._key || (!(b._key < a._key) && a._h < b._h); }
+
+   Key key(size_t i) const { return _keys[i + D-1]; }
+   Entry get(size_t i) const {
+      Entry e = { _keys[i + D-1], _data[i + D-1] }; return e; }
+   void set(size_t i, const Entry& e) {
+      _keys[i + D-1] = e._key; _data[i + D-1] = e._h; }
+   size_t minChild(size_t c, size_t e) const;
+
+   size_t size() const { return _data.size() - (D-1); }
+   void push_back(const Entry& e) {
+      _keys.push_back(e._key); _data.push_back(e._h); }
+   void pop_back() { _keys.pop_back(); _data.pop_back(); }
+   void resize(size_t n) { _keys.resize(n + D-1); _data.resize(n + D-1); }
+   void reserve(size_t n) { _keys.reserve(n + D-1); _data.reserve(n + D-1); }
+
+private:
+   typedef vector<Key, CacheAlignedAlloc<Key> >            Keys;
+   typedef vector<uint32_t, CacheAlignedAlloc<uint32_t> >  Handles;
+
+   KeyOf     _keyOf;
+   Keys      _keys;       // padding, then slot --> key
+   Handles   _data;       // padding, then slot --> handle
+};
+
+template <typename K, size_t D>
+size_t
+KeySlots<K, D>::minChild( size_t c, size_t e ) const
+{
+  const Key* k = &_keys[D-1];
+  const uint32_t* h = &_data[D-1];
+  size_t tmp = c;
+  if( e - c == D )
+  {
+    // a full group: fixed trip count, branch free
+    for( size_t j = c+1; j < c+D; ++j )
+      tmp = ( k[j] < k[tmp] || ( !( k[tmp] < k[j] ) && h[j] < h[tmp] ) )?
+            j: tmp;
+    return tmp;
+  }
+  for( size_t j = c+1; j < e; ++j )
+    if( k[j] < k[tmp] || ( !( k[tmp] < k[j] ) && h[j] < h[tmp] ) )
+      tmp = j;
+  return tmp;
+}
+
+template <class KeyOf, size_t D = 2>
+class KeyMinHeap : public HandleMinHeap<KeySlots<KeyOf, D>, D>
+{
+public:
+   typedef typename KeyOf::Key   Key;
+
+   KeyMinHeap(const KeyOf& k = KeyOf(), size_t s = 0) :
+      HandleMinHeap<KeySlots<KeyOf, D>, D>(k, s) {}
+
+   // the key of the handle in heap slot i
+   Key key(size_t i) const { return this->_slots.key(i); }
+};
+
 #endif // MY_MIN_HEAP_H
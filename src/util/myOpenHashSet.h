@@ -0,0 +1,461 @@
+/****************************************************************************
+  FileName     [ myOpenHashSet.h ]
+  PackageName  [ util ]
+  Synopsis     [ Define OpenHashSet ADT (open addressing) ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef MY_OPEN_HASH_SET_H
+#define MY_OPEN_HASH_SET_H
+
+#include <new>
+#include <cstring>
+#include <utility>
+#include <memory>
+#include <vector>
+#include <type_traits>
+#include <cassert>
+#include "util.h"
+#include "myHash.h"
+#include "myStats.h"
+#include "myArena.h"
+
+using namespace std;
+
+//---------------------------
+// Robin Hood probing helpers
+//---------------------------
+// The probing of OpenHashSet, shared with ConcurrentHashSet (which moves
+// the data by atomic words). "Slots" is a view of a table of size()
+// slots, each with a metadata byte as in OpenHashSet below:
+//    unsigned char dist(size_t i) const
+//    void setDist(size_t i, unsigned char d) const
+//    void swap(size_t i, Data& d) const      d <--> the data of slot i
+//    void put(size_t i, Data& d) const       d into the empty slot i
+//    void move(size_t to, size_t from) const
+//    void clear(size_t i) const              slot i is no longer used
+//
+struct RobinHood
+{
+   static size_t next(size_t n, size_t i) { return (++i == n)? 0: i; }
+
+   // the slot of the data of home bucket i with eq(slot) == true, or
+   // s.size(); "probes" is the distance it is found at (0 if not found)
+   template <class Slots, class Eq>
+   static size_t find(const Slots& s, size_t i, Eq eq, unsigned& probes) {
+      for (unsigned d = 1; d <= s.dist(i); ++d, i = next(s.size(), i))
+         if (s.dist(i) == d && eq(i)) { probes = d; return i; }
+      probes = 0;
+      return s.size();
+   }
+
+   // put d into the table from its home bucket i; if the cluster gets
+   // maxDist long, return false, and d is then the data (maybe another
+   // one) left out of the table
+   template <class Slots, class Data>
+   static bool place(const Slots& s, size_t i, Data& d,
+                     unsigned char maxDist) ;
+
+   // remove the data of slot i: shift the following cluster back by one,
+   // so there are no tombstones
+   template <class Slots>
+   static void remove(const Slots& s, size_t i) ;
+};
+
+template <class Slots, class Data>
+bool
+RobinHood::place( const Slots& s, size_t i, Data& cur,
+                  unsigned char maxDist )
+{
+  unsigned char d = 1;
+  while( s.dist( i ) )
+  {
+    // robin hood: the one farther from home takes the slot
+    if( s.dist( i ) < d )
+    {
+      unsigned char td = s.dist( i );
+      s.swap( i, cur );
+      s.setDist( i, d );
+      d = td;
+    }
+    i = next( s.size(), i );
+    if( ++d == maxDist )
+      return false;
+  }
+  s.put( i, cur );
+  s.setDist( i, d );
+  return true;
+}
+
+template <class Slots>
+void
+RobinHood::remove( const Slots& s, size_t i )
+{
+  for( size_t j = next( s.size(), i ); s.dist( j ) > 1;
+       i = j, j = next( s.size(), j ) )
+  {
+    s.move( i, j );
+    s.setDist( i, s.dist( j ) - 1 );
+  }
+  s.clear( i );
+  s.setDist( i, 0 );
+}
+
+//-------------------------
+// Define OpenHashSet class
+//-------------------------
+// Same interface, policies and requirements on "Data" as HashSet, but
+// all the data live in one flat slot array (Robin Hood linear probing)
+// instead of one vector per bucket.
+//
+// Every slot has a metadata byte "_dist":
+//    0     ==> empty slot
+//    d > 0 ==> the data sits (d-1) slots after its home bucket
+// Lookups stop as soon as they meet a slot that is closer to its home
+// than the probe is, and "==" is only called on slots with the same
+// distance (i.e. the same home bucket).
+// Removal shifts the following entries back, so there are no tombstones.
+//
+// Slots are raw storage; "Data" is only constructed when inserted, so no
+// default constructor is ever called. The slot array comes from "Alloc".
+//
+template <class Data, class Hasher = DataHash<Data>,
+          class Equal = DataEqual<Data>, class Alloc = allocator<Data> >
+class OpenHashSet
+{
+#define OPEN_HASH_MAX_DIST   255
+#define OPEN_HASH_MAX_LOAD   0.85
+
+public:
+   OpenHashSet(size_t b = 0, const Hasher& h = Hasher(),
+               const Equal& e = Equal(), const Alloc& a = Alloc()) :
+      _hasher(h), _equal(e), _alloc(a), _numSlots(0), _numData(0),
+      _maxLoad(OPEN_HASH_MAX_LOAD), _slots(nullptr), _dist(nullptr) {
+      if (b != 0) init(b); }
+   ~OpenHashSet() {
+      if (bulkReleased(_alloc) && is_trivially_destructible<Data>::value)
+         release();
+      else reset(); }
+
+   class iterator
+   {
+     friend class OpenHashSet<Data, Hasher, Equal, Alloc>;
+
+     public:
+     iterator( size_t i = 0,
+               const OpenHashSet<Data, Hasher, Equal, Alloc>* ptr = nullptr ):
+       _idx(i), _caller(ptr) {}
+
+     const Data& operator * () const { return _caller->_slots[_idx]; }
+     iterator& operator ++ () {
+       while( ++_idx < _caller->_numSlots && !_caller->_dist[_idx] ) ;
+       return (*this); }
+     iterator& operator -- () {
+       while( _idx != 0 && !_caller->_dist[--_idx] ) ;
+       return (*this); }
+     iterator  operator ++ (int) { auto tmp = *this; ++(*this); return tmp; }
+     iterator  operator -- (int) { auto tmp = *this; --(*this); return tmp; }
+     bool operator != (const iterator& i) const { return _idx != i._idx; }
+     bool operator == (const iterator& i) const { return _idx == i._idx; }
+
+     private:
+     size_t                     _idx;
+     const OpenHashSet<Data, Hasher, Equal, Alloc>*   _caller;
+   };
+
+   void init(size_t b);
+   void reset();
+   void clear();
+   void release();
+   size_t numBuckets() const { return _numSlots; }
+
+   // must be in (0, 1); the table always grows
+   double maxLoadFactor() const { return _maxLoad; }
+   void setMaxLoadFactor(double f) { if (f > 0 && f < 1) _maxLoad = f; }
+   // grow now so that n data fit without growing again
+   void reserve(size_t n) ;
+
+   iterator begin() const ;
+   iterator end() const { return iterator(_numSlots, this); }
+   bool empty() const { return _numData == 0; }
+   size_t size() const { return _numData; }
+
+   // same semantics as the HashSet counterparts
+   bool check(const Data& d) const { return findSlot(d) != _numSlots; }
+   bool query(Data& d) const ;
+   bool update(const Data& d) ;
+   bool insert(const Data& d) ;
+   void insertNew(const Data& d) { assert(!check(d)); place(Data(d)); }
+   bool remove(const Data& d) { return removeKey(d); }
+
+   template <class Key> const Data* findKey(const Key& k) const {
+     MY_STATS_LATENCY("OpenHashSet::findKey");
+     size_t i = findSlot(k); return (i != _numSlots)? _slots + i: nullptr; }
+   template <class Key> bool removeKey(const Key& k, Data* d = 0) ;
+
+   // For snapshots: places() gives where every data sits, in the order
+   // of the iterators; adopt() rebuilds the same table of b buckets from
+   // the data and their places, without hashing or comparing any.
+   // adopt() returns false, leaving the hash empty, if a place is not in
+   // a table of b buckets.
+   void places(vector<uint64_t>& p) const ;
+   bool adopt(size_t b, const Data* d, const uint64_t* p, size_t n) ;
+
+private:
+   Hasher            _hasher;
+   Equal             _equal;
+   Alloc             _alloc;
+   size_t            _numSlots;
+   size_t            _numData;
+   double            _maxLoad;
+   Data*             _slots;
+   unsigned char*    _dist;
+
+   // the table, as seen by RobinHood
+   struct Slots
+   {
+      size_t           _n;
+      Data*            _slots;
+      unsigned char*   _dist;
+
+      size_t size() const { return _n; }
+      unsigned char dist(size_t i) const { return _dist[i]; }
+      void setDist(size_t i, unsigned char d) const { _dist[i] = d; }
+      void swap(size_t i, Data& d) const { std::swap(d, _slots[i]); }
+      void put(size_t i, Data& d) const {
+         new (_slots + i) Data(std::move(d)); }
+      void move(size_t to, size_t from) const {
+         _slots[to] = std::move(_slots[from]); }
+      void clear(size_t i) const { _slots[i].~Data(); }
+   };
+   Slots slots() const { Slots s = { _numSlots, _slots, _dist }; return s; }
+
+   OpenHashSet(const OpenHashSet&);     // not copyable
+   OpenHashSet& operator = (const OpenHashSet&);
+
+   template <class Key>
+   size_t bucketNum(const Key& k) const {
+     return (_hasher(k) % _numSlots); }
+
+   // return _numSlots if k is not in the hash
+   template <class Key> size_t findSlot(const Key& k) const ;
+   // put d into the table; d must not be in the hash
+   void place(Data&& d) ;
+   void rehash(size_t b) ;
+};
+
+template <typename T, typename H, typename E, typename A>
+void
+OpenHashSet<T, H, E, A>::init( size_t b )
+{
+  reset();
+  _numSlots = b;
+  _slots = _alloc.allocate( b );
+  _dist  = new unsigned char[b];
+  memset( _dist, 0, b );
+}
+
+template <typename T, typename H, typename E, typename A>
+void
+OpenHashSet<T, H, E, A>::reset()
+{
+  if( _slots == nullptr )
+    return;
+  clear();
+  _alloc.deallocate( _slots, _numSlots );
+  delete [] _dist;
+  _slots = nullptr; _dist = nullptr;
+  _numSlots = 0;
+}
+
+// same as reset(), but the slots are left to the owner of the allocator
+template <typename T, typename H, typename E, typename A>
+void
+OpenHashSet<T, H, E, A>::release()
+{
+  assert( bulkReleased( _alloc ) && is_trivially_destructible<T>::value );
+  delete [] _dist;
+  _slots = nullptr; _dist = nullptr;
+  _numSlots = 0; _numData = 0;
+}
+
+template <typename T, typename H, typename E, typename A>
+void
+OpenHashSet<T, H, E, A>::clear()
+{
+  for( size_t i = 0; i < _numSlots; ++i )
+    if( _dist[i] )
+    {
+      _slots[i].~T();
+      _dist[i] = 0;
+    }
+  _numData = 0;
+}
+
+template <typename T, typename H, typename E, typename A>
+void
+OpenHashSet<T, H, E, A>::reserve( size_t n )
+{
+  if( n <= _numSlots * _maxLoad )
+    return;
+  size_t b = _numSlots;
+  do b = getNextHashSize( b ); while( n > b * _maxLoad );
+  rehash( b );
+}
+
+template <typename T, typename H, typename E, typename A>
+typename OpenHashSet<T, H, E, A>::iterator
+OpenHashSet<T, H, E, A>::begin() const
+{
+  size_t i = 0;
+  while( i < _numSlots && !_dist[i] ) ++i;
+  return iterator( i, this );
+}
+
+template <typename T, typename H, typename E, typename A>
+template <class K>
+size_t
+OpenHashSet<T, H, E, A>::findSlot( const K& other ) const
+{
+  if( _numData == 0 )
+    return _numSlots;
+  unsigned probes;
+  size_t i = RobinHood::find( slots(), bucketNum( other ),
+                              [&]( size_t j ) {
+                                return _equal( _slots[j], other ); },
+                              probes );
+  MY_STATS_COUNT( "OpenHashSet probes", probes );
+  return i;
+}
+
+template <typename T, typename H, typename E, typename A>
+bool
+OpenHashSet<T, H, E, A>::query( T& other ) const
+{
+  MY_STATS_LATENCY( "OpenHashSet::query" );
+  size_t i = findSlot( other );
+  if( i == _numSlots )
+    return false;
+  other = _slots[i];
+  return true;
+}
+
+template <typename T, typename H, typename E, typename A>
+bool
+OpenHashSet<T, H, E, A>::update( const T& other )
+{
+  MY_STATS_LATENCY( "OpenHashSet::update" );
+  size_t i = findSlot( other );
+  if( i != _numSlots )
+  {
+    _slots[i] = other;
+    return true;
+  }
+  place( T(other) );
+  return false;
+}
+
+template <typename T, typename H, typename E, typename A>
+bool
+OpenHashSet<T, H, E, A>::insert( const T& other )
+{
+  MY_STATS_LATENCY( "OpenHashSet::insert" );
+  if( findSlot( other ) != _numSlots )
+    return false;
+  place( T(other) );
+  return true;
+}
+
+template <typename T, typename H, typename E, typename A>
+template <class K>
+bool
+OpenHashSet<T, H, E, A>::removeKey( const K& other, T* d )
+{
+  MY_STATS_LATENCY( "OpenHashSet::removeKey" );
+  size_t i = findSlot( other );
+  if( i == _numSlots )
+    return false;
+  if( d != 0 )
+    *d = _slots[i];
+  RobinHood::remove( slots(), i );
+  --_numData;
+  return true;
+}
+
+// a place is the slot, times 256, plus its "_dist"
+template <typename T, typename H, typename E, typename A>
+void
+OpenHashSet<T, H, E, A>::places( vector<uint64_t>& p ) const
+{
+  p.clear();
+  p.reserve( _numData );
+  for( size_t i = 0; i < _numSlots; ++i )
+    if( _dist[i] )
+      p.push_back( ( uint64_t( i ) << 8 ) | _dist[i] );
+}
+
+template <typename T, typename H, typename E, typename A>
+bool
+OpenHashSet<T, H, E, A>::adopt( size_t b, const T* d, const uint64_t* p,
+                                size_t n )
+{
+  init( b );
+  for( size_t k = 0; k < n; ++k )
+  {
+    size_t i = p[k] >> 8;
+    unsigned char dist = p[k] & 0xff;
+    if( i >= b || dist == 0 || _dist[i] )
+    {
+      clear();
+      return false;
+    }
+    new ( _slots + i ) T( d[k] );
+    _dist[i] = dist;
+    ++_numData;
+  }
+  return true;
+}
+
+template <typename T, typename H, typename E, typename A>
+void
+OpenHashSet<T, H, E, A>::place( T&& other )
+{
+  if( _numSlots == 0
+      || _numData + 1 > _numSlots * _maxLoad )
+    rehash( getNextHashSize( _numSlots ) );
+
+  T cur( std::move( other ) );
+  if( !RobinHood::place( slots(), bucketNum( cur ), cur,
+                         OPEN_HASH_MAX_DIST ) )
+  {
+    // too long a cluster; "cur" is the only data not in the table
+    rehash( getNextHashSize( _numSlots ) );
+    place( std::move( cur ) );
+    return;
+  }
+  ++_numData;
+}
+
+template <typename T, typename H, typename E, typename A>
+void
+OpenHashSet<T, H, E, A>::rehash( size_t b )
+{
+  size_t oldNum = _numSlots;
+  T* oldSlots = _slots;
+  unsigned char* oldDist = _dist;
+
+  _slots = nullptr; _dist = nullptr;
+  init( b );
+  _numData = 0;
+  for( size_t i = 0; i < oldNum; ++i )
+    if( oldDist[i] )
+    {
+      place( std::move( oldSlots[i] ) );
+      oldSlots[i].~T();
+    }
+  _alloc.deallocate( oldSlots, oldNum );
+  delete [] oldDist;
+}
+
+#endif // MY_OPEN_HASH_SET_H
@@ -0,0 +1,249 @@
+/****************************************************************************
+  FileName     [ myRadixHeap.h ]
+  PackageName  [ util ]
+  Synopsis     [ Define RadixHeap ADT ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef MY_RADIX_HEAP_H
+#define MY_RADIX_HEAP_H
+
+#include <vector>
+#include <stdint.h>
+
+using namespace std;
+
+//-----------------------
+// Define RadixHeap class
+//-----------------------
+// A priority queue of 32-bit handles for unsigned integer keys, with the
+// interface of KeyMinHeap (see myMinHeap.h). "KeyOf" gives the key of a
+// handle and must define "KeyOf::Key" (an unsigned integer type).
+//
+// Keys are kept in buckets relative to "_last", the last min found:
+//    bucket 0      ==> key == _last
+//    bucket b > 0  ==> the highest bit in which key and _last differ is
+//                      bit b-1, i.e. key is in [_last + 2^(b-1), ...)
+// So every key of bucket b is smaller than every key of bucket b+1, and
+// a bucket b > 0 is split into lower buckets when the min is looked for
+// in it. As long as no key goes below "_last" (keys only increase, as
+// with TASKAssign), each key moves down at most 64 times: amortized
+// O(1) per operation instead of O(log n).
+//
+// Keys smaller than "_last" (e.g. a new task with a small load) go to an
+// extra unordered bucket. The next min() then takes the smallest of them
+// as "_last" and rebuckets all the keys, which is O(n).
+//
+// Slots: "operator []" and the slot numbers are positions in an unordered
+// array of the handles, only there to pick or list arbitrary elements.
+//
+template <class KeyOf>
+class RadixHeap
+{
+#define RADIX_BITS     64
+#define RADIX_BELOW    (RADIX_BITS + 1)
+#define RADIX_BUCKETS  (RADIX_BITS + 2)
+
+public:
+   typedef typename KeyOf::Key   Key;
+   typedef KeyOf                 Policy;
+
+   RadixHeap(const KeyOf& k = KeyOf(), size_t s = 0) :
+      _keyOf(k), _last(0), _used(0) {
+      if (s != 0) { _items.reserve(s); _pos.reserve(s); }
+   }
+   ~RadixHeap() {}
+
+   void clear();
+
+   uint32_t operator [] (size_t i) const { return _items[i]; }
+   size_t size() const { return _items.size(); }
+   size_t slot(uint32_t h) const { return _pos[h]; }
+
+   // We don't respond for the case the heap is empty!
+   uint32_t min() const { normalize(); return _buckets[0].back(); }
+   void insert(uint32_t h);
+   void insertAll(const vector<uint32_t>& hs) {
+      for (size_t i = 0; i < hs.size(); ++i) insert(hs[i]); }
+   void delMin() { delHandle(min()); }
+   void delData(size_t i);
+   void delHandle(uint32_t h) { delData(_pos[h]); }
+   void delHandles(const vector<uint32_t>& hs) {
+      for (size_t i = 0; i < hs.size(); ++i) delHandle(hs[i]); }
+
+   // the key of the handle in slot i has been changed (up or down)
+   void updateKey(size_t i);
+   void increaseKeys(vector<size_t>& slots) {
+      for (size_t i = 0; i < slots.size(); ++i) updateKey(slots[i]); }
+
+   // see IdxMinHeap::collect(); notAbove() must be monotone in the key
+   template <class Pred>
+   void collect(Pred notAbove, vector<size_t>& slots) const;
+
+private:
+   KeyOf                       _keyOf;
+   vector<uint32_t>            _items;      // slot   --> handle
+   vector<uint32_t>            _pos;        // handle --> slot
+   // per handle; the buckets are changed by min(), hence mutable
+   vector<Key>                 _key;
+   mutable vector<uint8_t>     _bucket;     // handle --> its bucket
+   mutable vector<uint32_t>    _at;         // handle --> index in it
+   mutable vector<uint32_t>    _buckets[RADIX_BUCKETS];
+   mutable Key                 _last;
+   mutable uint64_t            _used;       // bit b-1: bucket b non-empty
+
+   size_t bucketOf(Key k) const {
+      if (k < _last) return RADIX_BELOW;
+      return (k == _last)? 0: RADIX_BITS - __builtin_clzll(k ^ _last); }
+   void put(uint32_t h) const ;
+   void unlink(uint32_t h) const ;
+   // make bucket 0 hold the min
+   void normalize() const ;
+};
+
+template <typename K>
+void
+RadixHeap<K>::clear()
+{
+  _items.clear(); _pos.clear();
+  _key.clear(); _bucket.clear(); _at.clear();
+  for( size_t b = 0; b < RADIX_BUCKETS; ++b )
+    _buckets[b].clear();
+  _last = 0; _used = 0;
+}
+
+template <typename K>
+void
+RadixHeap<K>::insert( uint32_t h )
+{
+  if( h >= _pos.size() )
+  {
+    _pos.resize( h+1 ); _key.resize( h+1 );
+    _bucket.resize( h+1 ); _at.resize( h+1 );
+  }
+  _key[h] = _keyOf( h );
+  if( _items.empty() )
+    _last = _key[h];
+  _pos[h] = _items.size();
+  _items.push_back( h );
+  put( h );
+}
+
+template <typename K>
+void
+RadixHeap<K>::delData( size_t i )
+{
+  uint32_t h = _items[i];
+  unlink( h );
+  _items[i] = _items.back();
+  _pos[_items[i]] = i;
+  _items.pop_back();
+}
+
+template <typename K>
+void
+RadixHeap<K>::updateKey( size_t i )
+{
+  uint32_t h = _items[i];
+  unlink( h );
+  _key[h] = _keyOf( h );
+  put( h );
+}
+
+template <typename K>
+template <class Pred>
+void
+RadixHeap<K>::collect( Pred notAbove, vector<size_t>& slots ) const
+{
+  // bucket by bucket in increasing key order; all the matches are found
+  // once a bucket has some key that does not match.
+  size_t b = RADIX_BELOW;
+  while( true )
+  {
+    bool done = false;
+    const vector<uint32_t>& bucket = _buckets[b];
+    for( size_t j = 0; j < bucket.size(); ++j )
+      if( notAbove( bucket[j] ) )
+        slots.push_back( _pos[bucket[j]] );
+      else
+        done = true;
+    if( done )
+      return;
+    if( b == RADIX_BELOW )
+      b = 0;
+    else
+    {
+      uint64_t rest = ( b == RADIX_BITS )? 0: _used & ( ~0ull << b );
+      if( rest == 0 )
+        return;
+      b = __builtin_ctzll( rest ) + 1;
+    }
+  }
+}
+
+template <typename K>
+void
+RadixHeap<K>::put( uint32_t h ) const
+{
+  size_t b = bucketOf( _key[h] );
+  _bucket[h] = b;
+  _at[h] = _buckets[b].size();
+  _buckets[b].push_back( h );
+  if( b != 0 && b != RADIX_BELOW )
+    _used |= 1ull << (b-1);
+}
+
+template <typename K>
+void
+RadixHeap<K>::unlink( uint32_t h ) const
+{
+  size_t b = _bucket[h];
+  vector<uint32_t>& bucket = _buckets[b];
+  uint32_t last = bucket.back();
+  bucket[_at[h]] = last;
+  _at[last] = _at[h];
+  bucket.pop_back();
+  if( bucket.empty() && b != 0 && b != RADIX_BELOW )
+    _used &= ~( 1ull << (b-1) );
+}
+
+template <typename K>
+void
+RadixHeap<K>::normalize() const
+{
+  vector<uint32_t> moved;
+  if( !_buckets[RADIX_BELOW].empty() )
+  {
+    // a key went below _last: start over from the smallest of them
+    Key m = _key[_buckets[RADIX_BELOW][0]];
+    for( size_t j = 1; j < _buckets[RADIX_BELOW].size(); ++j )
+      if( _key[_buckets[RADIX_BELOW][j]] < m )
+        m = _key[_buckets[RADIX_BELOW][j]];
+    _last = m;
+    for( size_t b = 0; b < RADIX_BUCKETS; ++b )
+    {
+      moved.insert( moved.end(), _buckets[b].begin(), _buckets[b].end() );
+      _buckets[b].clear();
+    }
+    _used = 0;
+    for( size_t j = 0; j < moved.size(); ++j )
+      put( moved[j] );
+    return;
+  }
+  if( !_buckets[0].empty() || _used == 0 )
+    return;
+  // split the first non-empty bucket around its min
+  size_t b = __builtin_ctzll( _used ) + 1;
+  moved.swap( _buckets[b] );
+  _used &= ~( 1ull << (b-1) );
+  Key m = _key[moved[0]];
+  for( size_t j = 1; j < moved.size(); ++j )
+    if( _key[moved[j]] < m )
+      m = _key[moved[j]];
+  _last = m;
+  for( size_t j = 0; j < moved.size(); ++j )
+    put( moved[j] );
+}
+
+#endif // MY_RADIX_HEAP_H
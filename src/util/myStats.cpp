@@ -0,0 +1,101 @@
+/****************************************************************************
+  FileName     [ myStats.cpp ]
+  PackageName  [ util ]
+  Synopsis     [ Define the optional latency and count statistics ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iomanip>
+#include <cstring>
+#include "myStats.h"
+
+using namespace std;
+
+void
+LogHistogram::reset()
+{
+  memset( _counts, 0, sizeof( _counts ) );
+  _count = _sum = _max = 0;
+}
+
+uint64_t
+LogHistogram::percentile( double p ) const
+{
+  uint64_t need = uint64_t( p * _count ), seen = 0;
+  for( size_t i = 0; i < LOG_HIST_BUCKETS; ++i )
+  {
+    seen += _counts[i];
+    if( seen > need )
+      // the bucket's upper end, but never above the largest value
+      return ( i+1 < LOG_HIST_BUCKETS && lowest( i+1 ) - 1 < _max )?
+             lowest( i+1 ) - 1: _max;
+  }
+  return _max;
+}
+
+void
+CountHistogram::reset()
+{
+  memset( _counts, 0, sizeof( _counts ) );
+  _count = _sum = 0;
+}
+
+void
+CountHistogram::print( ostream& os ) const
+{
+  for( size_t v = 0; v <= COUNT_HIST_MAX; ++v )
+  {
+    if( _counts[v] == 0 )
+      continue;
+    os << "   " << ( v == COUNT_HIST_MAX? ">=": "  " ) << setw(4) << v
+       << setw(14) << _counts[v] << setw(8) << fixed << setprecision(2)
+       << 100.0 * _counts[v] / _count << '%' << endl;
+  }
+  os.unsetf( ios::floatfield );
+  os << setprecision(6);
+}
+
+void
+MyStats::report( ostream& os ) const
+{
+  bool any = false;
+  for( auto it = _latency.begin(); it != _latency.end(); ++it )
+  {
+    const LogHistogram& h = it->second;
+    if( h.count() == 0 )
+      continue;
+    if( !any )
+    {
+      os << left << setw(24) << "Latency (ns)" << right << setw(10) << "count"
+         << setw(10) << "mean" << setw(10) << "p50" << setw(10) << "p99"
+         << setw(10) << "p999" << setw(12) << "max" << endl;
+      any = true;
+    }
+    os << left << setw(24) << it->first << right << setw(10) << h.count()
+       << setw(10) << uint64_t( h.mean() ) << setw(10) << h.percentile( 0.5 )
+       << setw(10) << h.percentile( 0.99 ) << setw(10) << h.percentile( 0.999 )
+       << setw(12) << h.max() << endl;
+  }
+  for( auto it = _counts.begin(); it != _counts.end(); ++it )
+  {
+    const CountHistogram& h = it->second;
+    if( h.count() == 0 )
+      continue;
+    any = true;
+    os << it->first << ": " << h.count() << " times, mean " << h.mean()
+       << endl;
+    h.print( os );
+  }
+  if( !any )
+    os << "No statistics gathered." << endl;
+}
+
+void
+MyStats::reset()
+{
+  for( auto it = _latency.begin(); it != _latency.end(); ++it )
+    it->second.reset();
+  for( auto it = _counts.begin(); it != _counts.end(); ++it )
+    it->second.reset();
+}
@@ -0,0 +1,150 @@
+/****************************************************************************
+  FileName     [ myStats.h ]
+  PackageName  [ util ]
+  Synopsis     [ Define the optional latency and count statistics ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef MY_STATS_H
+#define MY_STATS_H
+
+#include <iostream>
+#include <string>
+#include <map>
+#include <stdint.h>
+#include <time.h>
+
+using namespace std;
+
+//----------------------------------------------------------------------
+//    Statistics, only with -DMY_STATS
+//----------------------------------------------------------------------
+// Code is instrumented with the macros below; without MY_STATS they
+// expand to nothing, so the instrumented code is exactly as before.
+//
+//    MY_STATS_LATENCY("name")    ==> time the rest of the enclosing
+//                                    block (at most once per block)
+//    MY_STATS_COUNT("name", v)   ==> count one occurrence of value v,
+//                                    e.g. a probe length or sift depth
+//    MY_STATS_ONLY(code)         ==> code only needed by the above
+//
+// The histograms are kept by name in "myStats" (see util.cpp), so all
+// the template instances of a function share theirs.
+//
+
+// HDR-style histogram: 2^LOG_HIST_SUB_BITS linear sub-buckets per power
+// of 2, so any value is off by less than 1/2^LOG_HIST_SUB_BITS of itself.
+class LogHistogram
+{
+#define LOG_HIST_SUB_BITS   3
+#define LOG_HIST_SUB        (1 << LOG_HIST_SUB_BITS)
+#define LOG_HIST_BUCKETS    ((65 - LOG_HIST_SUB_BITS) * LOG_HIST_SUB)
+
+public:
+   LogHistogram() { reset(); }
+
+   void reset();
+   void add(uint64_t v) {
+      ++_counts[index(v)]; ++_count; _sum += v; if (v > _max) _max = v; }
+
+   uint64_t count() const { return _count; }
+   uint64_t max() const { return _max; }
+   double mean() const { return _count? double(_sum) / _count: 0; }
+   // the least bucket bound with at least p of the values below it
+   uint64_t percentile(double p) const;
+
+private:
+   uint64_t   _counts[LOG_HIST_BUCKETS];
+   uint64_t   _count;
+   uint64_t   _sum;
+   uint64_t   _max;
+
+   static size_t index(uint64_t v) {
+      if (v < LOG_HIST_SUB) return v;
+      size_t e = 63 - __builtin_clzll(v);
+      return (e - LOG_HIST_SUB_BITS + 1) * LOG_HIST_SUB
+             + ((v >> (e - LOG_HIST_SUB_BITS)) & (LOG_HIST_SUB - 1)); }
+   // the smallest value in bucket i
+   static uint64_t lowest(size_t i) {
+      if (i < LOG_HIST_SUB) return i;
+      size_t e = i / LOG_HIST_SUB + LOG_HIST_SUB_BITS - 1;
+      return (uint64_t(1) << e)
+             | (uint64_t(i % LOG_HIST_SUB) << (e - LOG_HIST_SUB_BITS)); }
+};
+
+// exact counts of the small values 0 ... COUNT_HIST_MAX-1; the larger
+// ones share the last bucket
+class CountHistogram
+{
+#define COUNT_HIST_MAX   32
+
+public:
+   CountHistogram() { reset(); }
+
+   void reset();
+   void add(size_t v) {
+      ++_counts[(v < COUNT_HIST_MAX)? v: COUNT_HIST_MAX];
+      ++_count; _sum += v; }
+
+   uint64_t count() const { return _count; }
+   double mean() const { return _count? double(_sum) / _count: 0; }
+   void print(ostream& os) const;
+
+private:
+   uint64_t   _counts[COUNT_HIST_MAX + 1];
+   uint64_t   _count;
+   uint64_t   _sum;
+};
+
+class MyStats
+{
+public:
+   // the histogram of this name; created (empty) on the first call
+   LogHistogram& latency(const string& name) { return _latency[name]; }
+   CountHistogram& counts(const string& name) { return _counts[name]; }
+
+   bool empty() const { return _latency.empty() && _counts.empty(); }
+   void report(ostream& os) const;
+   // empty all the histograms; the names stay
+   void reset();
+
+private:
+   map<string, LogHistogram>     _latency;   // in ns
+   map<string, CountHistogram>   _counts;
+};
+
+extern MyStats myStats;
+
+// adds the time from its construction to its destruction, in ns
+class ScopedLatency
+{
+public:
+   ScopedLatency(LogHistogram& h) : _hist(h) { _start = now(); }
+   ~ScopedLatency() { _hist.add(now() - _start); }
+
+private:
+   LogHistogram&   _hist;
+   uint64_t        _start;
+
+   static uint64_t now() {
+      timespec t;
+      clock_gettime(CLOCK_MONOTONIC, &t);
+      return uint64_t(t.tv_sec) * 1000000000ull + t.tv_nsec; }
+};
+
+#ifdef MY_STATS
+#define MY_STATS_LATENCY(name) \
+   static LogHistogram& myStatsHist_ = myStats.latency(name); \
+   ScopedLatency myStatsTimer_(myStatsHist_)
+#define MY_STATS_COUNT(name, v) \
+   do { static CountHistogram& h_ = myStats.counts(name); h_.add(v); } \
+   while (0)
+#define MY_STATS_ONLY(code)  code
+#else
+#define MY_STATS_LATENCY(name)
+#define MY_STATS_COUNT(name, v)
+#define MY_STATS_ONLY(code)
+#endif
+
+#endif // MY_STATS_H
@@ -0,0 +1,165 @@
+/****************************************************************************
+  FileName     [ myThreadPool.h ]
+  PackageName  [ util ]
+  Synopsis     [ Define MyThreadPool, a work-stealing pool of threads ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef MY_THREAD_POOL_H
+#define MY_THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+using namespace std;
+
+//-------------------------
+// Define MyThreadPool class
+//-------------------------
+// run() deals a round of jobs out to the workers, one deque each, and
+// waits until all of them are done. A worker takes the jobs of its own
+// deque from the back, and when it runs out, steals from the front of
+// the others'; so uneven jobs still keep every worker busy.
+// Between rounds the workers sleep.
+//
+class MyThreadPool
+{
+public:
+   typedef function<void()> Job;
+
+   // n == 0 ==> one worker per core
+   MyThreadPool(size_t n = 0) ;
+   ~MyThreadPool() ;
+
+   size_t size() const { return _queues.size(); }
+   // the jobs may run in any order, in parallel
+   void run(const vector<Job>& jobs) ;
+
+private:
+   struct Queue
+   {
+      mutex                 _lock;
+      deque<const Job*>     _jobs;
+   };
+
+   vector<Queue*>        _queues;      // one per worker
+   vector<thread>        _workers;
+   mutex                 _lock;        // for the four below
+   condition_variable    _wake;
+   condition_variable    _done;
+   size_t                _round;       // the number of run() so far
+   bool                  _quit;
+   atomic<size_t>        _left;        // jobs not yet done in this round
+
+   MyThreadPool(const MyThreadPool&);   // not copyable
+   MyThreadPool& operator = (const MyThreadPool&);
+
+   bool take(size_t w, const Job*& j) ;
+   void work(size_t w) ;
+};
+
+inline
+MyThreadPool::MyThreadPool( size_t n )
+: _round( 0 ), _quit( false ), _left( 0 )
+{
+  if( n == 0 )
+    n = thread::hardware_concurrency();
+  if( n == 0 )
+    n = 1;
+  for( size_t w = 0; w < n; ++w )
+    _queues.push_back( new Queue );
+  for( size_t w = 0; w < n; ++w )
+    _workers.push_back( thread( &MyThreadPool::work, this, w ) );
+}
+
+inline
+MyThreadPool::~MyThreadPool()
+{
+  {
+    lock_guard<mutex> guard( _lock );
+    _quit = true;
+  }
+  _wake.notify_all();
+  for( size_t w = 0; w < _workers.size(); ++w )
+    _workers[w].join();
+  for( size_t w = 0; w < _queues.size(); ++w )
+    delete _queues[w];
+}
+
+inline void
+MyThreadPool::run( const vector<Job>& jobs )
+{
+  if( jobs.empty() )
+    return;
+  _left.store( jobs.size() );
+  for( size_t i = 0; i < jobs.size(); ++i )
+  {
+    Queue& q = *_queues[i % _queues.size()];
+    lock_guard<mutex> guard( q._lock );
+    q._jobs.push_back( &jobs[i] );
+  }
+  unique_lock<mutex> guard( _lock );
+  ++_round;
+  _wake.notify_all();
+  _done.wait( guard, [this]{ return _left.load() == 0; } );
+}
+
+// own deque first, from the back; then steal from the front of the next
+// ones in turn
+inline bool
+MyThreadPool::take( size_t w, const Job*& j )
+{
+  for( size_t k = 0; k < _queues.size(); ++k )
+  {
+    Queue& q = *_queues[( w + k ) % _queues.size()];
+    lock_guard<mutex> guard( q._lock );
+    if( q._jobs.empty() )
+      continue;
+    if( k == 0 )
+    {
+      j = q._jobs.back();
+      q._jobs.pop_back();
+    }
+    else
+    {
+      j = q._jobs.front();
+      q._jobs.pop_front();
+    }
+    return true;
+  }
+  return false;
+}
+
+inline void
+MyThreadPool::work( size_t w )
+{
+  size_t seen = 0;
+  for( ;; )
+  {
+    {
+      unique_lock<mutex> guard( _lock );
+      _wake.wait( guard, [&]{ return _quit || _round != seen; } );
+      if( _quit )
+        return;
+      seen = _round;
+    }
+    const Job* j;
+    while( take( w, j ) )
+    {
+      (*j)();
+      if( _left.fetch_sub( 1 ) == 1 )
+      {
+        lock_guard<mutex> guard( _lock );
+        _done.notify_all();
+      }
+    }
+  }
+}
+
+#endif // MY_THREAD_POOL_H
@@ -12,6 +12,12 @@
 #include <unistd.h>
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
+#include <time.h>
 #include <sys/times.h>
 #include <sys/resource.h>
 
@@ -33,6 +39,21 @@ public:
       _periodUsedTime = _totalUsedTime = 0.0;
    }
 
+   // resident set size now and at its peak, in MB; both are read from
+   // /proc (Linux), else the peak is from getrusage() and the current
+   // one is 0.
+   double currentRss() const { return procStatus("VmRSS:"); }
+   double peakRss() const {
+      double m = procStatus("VmHWM:");
+      return (m != 0)? m: checkMem();
+   }
+   void reportRss(ostream& os) const {
+      streamsize p = os.precision();
+      os << "Memory (RSS)     : " << setprecision(4) << currentRss()
+         << " M Bytes (peak " << peakRss() << " M Bytes)" << endl;
+      os.precision(p);
+   }
+
    void report(bool repTime, bool repMem) {
       if (repTime) {
          setTimeUsage();
@@ -59,6 +80,14 @@ private:
    double     _totalUsedTime;
 
    // private functions
+   static double procStatus(const string& key) {
+      ifstream status("/proc/self/status");
+      string tok;
+      double kb;
+      while (status >> tok)
+         if (tok == key && status >> kb) return kb / 1024;
+      return 0;
+   }
    double checkMem() const {
       struct rusage usage;
       if(0 == getrusage(RUSAGE_SELF, &usage))
@@ -85,4 +114,91 @@ private:
       
 };
 
+//----------------------------------------------------------------------
+//    MyProfile / MyTimer: wall clock timers per name
+//----------------------------------------------------------------------
+// A MyTimer times its own lifetime with CLOCK_MONOTONIC (ns resolution)
+// and adds it to the entry of its name in a MyProfile. Timers nest: the
+// time of the inner ones is also counted as "children" of the one they
+// run in, so that every entry has both its total and its self time.
+// A MyProfile is off until setOn(); the timers on it then read no clock
+// and record nothing.
+//
+class MyProfile
+{
+public:
+   MyProfile() : _on(false) {}
+
+   struct Entry
+   {
+      Entry() : _count(0), _total(0), _self(0), _max(0) {}
+      size_t     _count;
+      uint64_t   _total;     // ns, including the nested timers
+      uint64_t   _self;      // ns, excluding them
+      uint64_t   _max;
+   };
+
+   static uint64_t now() {
+      timespec t;
+      clock_gettime(CLOCK_MONOTONIC, &t);
+      return uint64_t(t.tv_sec) * 1000000000ull + t.tv_nsec;
+   }
+
+   bool on() const { return _on; }
+   void setOn(bool o) { _on = o; }
+
+   // called by MyTimer
+   void push() { _stack.push_back(0); }
+   void pop(const string& name, uint64_t ns) {
+      Entry& e = _entries[name];
+      ++e._count; e._total += ns; e._self += ns - _stack.back();
+      if (ns > e._max) e._max = ns;
+      _stack.pop_back();
+      if (!_stack.empty()) _stack.back() += ns;
+   }
+
+   const map<string, Entry>& entries() const { return _entries; }
+   void reset() { _entries.clear(); }
+   void report(ostream& os) const {
+      ios::fmtflags f = os.flags();
+      streamsize p = os.precision();
+      os << left << setw(16) << "Name" << right << setw(8) << "count"
+         << setw(12) << "total(ms)" << setw(12) << "self(ms)"
+         << setw(12) << "mean(ms)" << setw(12) << "max(ms)" << endl;
+      for (map<string, Entry>::const_iterator it = _entries.begin();
+           it != _entries.end(); ++it) {
+         const Entry& e = it->second;
+         os << left << setw(16) << it->first << right << setw(8) << e._count
+            << fixed << setprecision(3)
+            << setw(12) << e._total * 1e-6 << setw(12) << e._self * 1e-6
+            << setw(12) << e._total * 1e-6 / e._count
+            << setw(12) << e._max * 1e-6 << endl;
+      }
+      os.flags(f);
+      os.precision(p);
+   }
+
+private:
+   map<string, Entry>   _entries;
+   vector<uint64_t>     _stack;     // ns of the children of each timer
+   bool                 _on;
+};
+
+class MyTimer
+{
+public:
+   MyTimer(const string& name, MyProfile& p)
+      : _name(name), _profile(p), _start(0) {
+      if (p.on()) { p.push(); _start = MyProfile::now(); } }
+   ~MyTimer() { if (_profile.on()) _profile.pop(_name, elapsed()); }
+
+   // ns so far; only while the profile is on
+   uint64_t elapsed() const { return MyProfile::now() - _start; }
+
+private:
+   string       _name;
+   MyProfile&   _profile;
+   uint64_t     _start;
+};
+
 #endif // MY_USAGE_H
@@ -0,0 +1,41 @@
+/****************************************************************************
+  FileName     [ rnGen.cpp ]
+  PackageName  [ util ]
+  Synopsis     [ Define the batch part of FastRandomNumGen ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2014-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include "rnGen.h"
+
+using namespace std;
+
+// Both halves of every next() are used; the loop has no call in it, so
+// the state stays in registers.
+void
+FastRandomNumGen::fill( uint32_t* p, size_t n, uint32_t range )
+{
+  size_t i = 0;
+  for( ; i + 1 < n; i += 2 )
+  {
+    uint64_t r = next();
+    p[i] = bounded( uint32_t( r >> 32 ), range );
+    p[i + 1] = bounded( uint32_t( r ), range );
+  }
+  if( i < n )
+    p[i] = (*this)( range );
+}
+
+void
+FastRandomNumGen::fill( char* p, size_t n, char first, uint32_t range )
+{
+  size_t i = 0;
+  for( ; i + 1 < n; i += 2 )
+  {
+    uint64_t r = next();
+    p[i] = char( first + bounded( uint32_t( r >> 32 ), range ) );
+    p[i + 1] = char( first + bounded( uint32_t( r ), range ) );
+  }
+  if( i < n )
+    p[i] = char( first + (*this)( range ) );
+}
@@ -12,10 +12,17 @@
 #include <sys/types.h>
 #include <stdlib.h>  
 #include <limits.h>
+#include <stdint.h>
 
 #define my_srandom  srandom
 #define my_random   random
 
+// The legacy generator on the global random(): all the instances share
+// one state. rnGen is one, so that TASKNew -Random draws the same numbers,
+// and so makes the same nodes, as the reference program. TASKRemove
+// -Random draws the same numbers too, but they are queue slots: its
+// victims are the same only while the task queue has the same layout
+// as the reference one (e.g. -DTASK_HEAP_ARITY=2 and no equal loads).
 class RandomNumGen
 {
    public:
@@ -26,5 +33,61 @@ class RandomNumGen
       }
 };
 
+// xoshiro256** with a state of its own per instance, so any number of
+// them (e.g. one per thread) run without sharing anything. Seeded through
+// splitmix64, as its authors recommend.
+// Its numbers are not those of random(): only RandomNumGen reproduces
+// the reference program, so whatever draws from FastRandomNumGen (e.g.
+// TASKBench) has no counterpart there.
+class FastRandomNumGen
+{
+   public:
+      FastRandomNumGen(uint64_t seed = 0) { setSeed(seed); }
+
+      void setSeed(uint64_t seed) {
+         for (int i = 0; i < 4; ++i) {
+            uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            _s[i] = z ^ (z >> 31);
+         }
+      }
+      uint64_t next() {
+         uint64_t r = rotl(_s[1] * 5, 7) * 9, t = _s[1] << 17;
+         _s[2] ^= _s[0]; _s[3] ^= _s[1]; _s[1] ^= _s[2]; _s[0] ^= _s[3];
+         _s[2] ^= t; _s[3] = rotl(_s[3], 45);
+         return r;
+      }
+      // uniform in [0, range), range > 0; unlike RandomNumGen, never
+      // range itself
+      uint32_t operator() (uint32_t range) {
+         return bounded(uint32_t(next() >> 32), range); }
+      // uniform in [0, 1)
+      double unit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+      // n numbers in [0, range), two per next()
+      void fill(uint32_t* p, size_t n, uint32_t range) ;
+      // n characters in [first, first + range)
+      void fill(char* p, size_t n, char first, uint32_t range) ;
+
+   private:
+      uint64_t   _s[4];
+
+      static uint64_t rotl(uint64_t x, int k) {
+         return (x << k) | (x >> (64 - k)); }
+      // Lemire's multiply-shift: x * range / 2^32, redrawn in the rare
+      // case that x falls in the uneven part, so there is no bias and
+      // (almost) never a division
+      uint32_t bounded(uint32_t x, uint32_t range) {
+         uint64_t m = uint64_t(x) * range;
+         if (uint32_t(m) < range) {
+            uint32_t t = uint32_t(-range) % range;
+            while (uint32_t(m) < t)
+               m = uint64_t(uint32_t(next() >> 32)) * range;
+         }
+         return uint32_t(m >> 32);
+      }
+};
+
 #endif // RN_GEN_H
 
@@ -16,6 +16,7 @@
 #include <algorithm>
 #include "rnGen.h"
 #include "myUsage.h"
+#include "myStats.h"
 
 using namespace std;
 
@@ -25,6 +26,8 @@ using namespace std;
 
 RandomNumGen  rnGen(0);  // use random seed = 0
 MyUsage       myUsage;
+MyProfile     myProfile;
+MyStats       myStats;
 
 
 //----------------------------------------------------------------------
@@ -56,23 +59,34 @@ int listDir
    return 0;
 }
 
+// The prime sizes of a hash, and for each one the number of data below
+// which getHashSize() picks it.
+static const struct { size_t _below, _size; } hashSizes[] = {
+   { 8, 7 }, { 16, 13 }, { 32, 31 }, { 64, 61 }, { 128, 127 },
+   { 512, 509 }, { 2048, 1499 }, { 8192, 4999 }, { 32768, 13999 },
+   { 131072, 59999 }, { 524288, 100019 }, { 2097152, 300007 },
+   { 8388608, 900001 }, { 33554432, 1000003 }, { 134217728, 3000017 },
+   { 536870912, 5000011 }, { size_t(-1), 7000003 }
+};
+static const size_t numHashSizes = sizeof(hashSizes) / sizeof(hashSizes[0]);
+
 size_t getHashSize(size_t s) {
-   if (s < 8) return 7;
-   if (s < 16) return 13;
-   if (s < 32) return 31;
-   if (s < 64) return 61;
-   if (s < 128) return 127;
-   if (s < 512) return 509;
-   if (s < 2048) return 1499;
-   if (s < 8192) return 4999;
-   if (s < 32768) return 13999;
-   if (s < 131072) return 59999;
-   if (s < 524288) return 100019;
-   if (s < 2097152) return 300007;
-   if (s < 8388608) return 900001;
-   if (s < 33554432) return 1000003;
-   if (s < 134217728) return 3000017;
-   if (s < 536870912) return 5000011;
-   return 7000003;
+   size_t i = 0;
+   while (s >= hashSizes[i]._below && i + 1 < numHashSizes) ++i;
+   return hashSizes[i]._size;
+}
+
+// The next size after "b" for a growing hash: the first size on the
+// ladder above that is at least twice "b". Beyond the ladder, the
+// smallest prime not less than 2*b.
+size_t getNextHashSize(size_t b) {
+   for (size_t i = 0; i < numHashSizes; ++i)
+      if (hashSizes[i]._size >= 2 * b) return hashSizes[i]._size;
+   for (size_t p = 2 * b + 1; ; p += 2) {
+      bool isPrime = true;
+      for (size_t d = 3; d * d <= p && isPrime; d += 2)
+         if (p % d == 0) isPrime = false;
+      if (isPrime) return p;
+   }
 }
 
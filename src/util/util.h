@@ -18,6 +18,7 @@ using namespace std;
 // Extern global variable defined in util.cpp
 extern RandomNumGen  rnGen;
 extern MyUsage       myUsage;
+extern MyProfile     myProfile;
 
 // In myString.cpp
 extern int myStrNCmp(const string& s1, const string& s2, unsigned n);
@@ -33,6 +34,7 @@ extern char myGetChar();
 // In util.cpp
 extern int listDir(vector<string>&, const string&, const string&);
 extern size_t getHashSize(size_t s);
+extern size_t getNextHashSize(size_t b);
 
 // Other utility template functions
 template<class T>